@@ -20,6 +20,8 @@
 #include "utils/timeutil.h" //for getRealTime()
 #include "utils/progress.h" //for progress_display
 #include "alignmentsummary.h"
+#include "mappedalignment.h"
+#include "utils/MPIHelper.h"
 
 #include <Eigen/LU>
 #ifdef USE_BOOST
@@ -761,6 +763,62 @@ bool Alignment::isGapOnlySeq(int seq) const {
     return true;
 }
 
+/** identifies pattern cache files */
+const char PATTERN_CACHE_MAGIC[8] = {'I', 'Q', 'P', 'T', 'N', 'C', 'A', 'C'};
+
+/** version of the pattern cache format, increase when the format changes */
+const uint32_t PATTERN_CACHE_VERSION = 1;
+
+/** written in native byte order to reject cache files from other platforms */
+const uint32_t PATTERN_CACHE_BYTE_ORDER = 0x01020304;
+
+/**
+    compute the name of the pattern cache file and the key identifying the content of an alignment file
+    @param filename alignment file name
+    @param sequence_type user-defined sequence type or nullptr
+    @param intype alignment file format
+    @param[out] cache_file cache file name next to the checkpoint, PREFIX[.ALIGNMENT][.SEQTYPE].alncache
+    @param[out] key checksum of the alignment file and reading options the patterns depend on
+    @return FALSE if the patterns of the alignment file cannot be cached
+*/
+static bool getPatternCacheKey(const char *filename, const char *sequence_type, InputType intype,
+                               string &cache_file, string &key) {
+    Params &params = Params::getInstance();
+    // NEXUS and counts files define more than sequences and patterns
+    if (intype == IN_NEXUS || intype == IN_COUNTS) {
+        return false;
+    }
+    MappedFile aln_file;
+    if (!aln_file.open(filename)) {
+        return false;
+    }
+    double checksum_start = getRealTime();
+    ostringstream key_str;
+    key_str << "size=" << aln_file.getSize() << ";crc32=" << aln_file.computeChecksum()
+            << ";format=" << intype << ";seqtype=" << (sequence_type ? sequence_type : "")
+            << ";sequential=" << params.phylip_sequential_format;
+    key = key_str.str();
+    if (verbose_mode >= VB_MED) {
+        cout << "Checksum of alignment file took " << (getRealTime() - checksum_start) << " seconds." << endl;
+    }
+    cache_file = params.out_prefix;
+    if (!params.aln_file || strcmp(filename, params.aln_file) != 0) {
+        // alignment of a partition
+        string name = filename;
+        size_t pos = name.find_last_of("/\\");
+        if (pos != string::npos) {
+            name = name.substr(pos+1);
+        }
+        cache_file += "." + name;
+    }
+    if (sequence_type && sequence_type[0]) {
+        // partitions may read the same file with different sequence types
+        cache_file += (string)"." + sequence_type;
+    }
+    cache_file += ".alncache";
+    return true;
+}
+
 Alignment::Alignment(char *filename, char *sequence_type, InputType &intype, string model)
 : Alignment() {
     this->model_name = model;
@@ -771,8 +829,15 @@ Alignment::Alignment(char *filename, char *sequence_type, InputType &intype, str
     double readStart = getRealTime();
     cout << "Reading alignment file " << filename << " ... ";
     intype = detectInputFile(filename);
+    string cache_file, cache_key;
+    bool use_cache = Params::getInstance().aln_cache &&
+        getPatternCacheKey(filename, sequence_type, intype, cache_file, cache_key);
+    bool cache_read = false;
     try {
-        if (intype == IN_NEXUS) {
+        if (use_cache && readPatternCache(cache_file, cache_key)) {
+            cache_read = true;
+            cout << "Site patterns read from " << cache_file << endl;
+        } else if (intype == IN_NEXUS) {
             cout << "Nexus format detected" << endl;
             readNexus(filename);
         } else if (intype == IN_FASTA) {
@@ -810,6 +875,9 @@ Alignment::Alignment(char *filename, char *sequence_type, InputType &intype, str
     if (getNSeq() < 3) {
         outError("Alignment must have at least 3 sequences");
     }
+    if (use_cache && !cache_read) {
+        writePatternCache(cache_file, cache_key);
+    }
     double constCountStart = getRealTime();
     countConstSites();
     if (verbose_mode >= VB_MED) {
@@ -1451,6 +1519,140 @@ bool Alignment::addPattern(const Pattern &pat, bool *gaps_only) {
     return add;
 }
 
+/** consecutive sites whose patterns are made unique locally by one thread */
+struct PatternChunk {
+    vector<Pattern> patterns; // local patterns in order of first occurrence
+    vector<size_t> hashes; // hash value of each local pattern
+    IntVector owner_chunk; // chunk of the first occurrence of each local pattern in the alignment
+    IntVector owner_ptn; // local index of the first occurrence in owner_chunk
+    IntVector ptn_id; // final pattern ID of each local pattern
+};
+
+bool Alignment::addPatternsParallel(StrVector &block, size_t offset, size_t start, size_t end,
+                                    char *char_to_state, int &num_gaps_only, progress_display &progress) {
+#ifdef _OPENMP
+    size_t nseq = getNSeq();
+    size_t nsite = end - start;
+    int num_threads = omp_get_max_threads();
+    size_t chunk_size = max((size_t)4096, nsite / (num_threads * 8) + 1);
+    int num_chunks = (nsite + chunk_size - 1) / chunk_size;
+    int num_shards = num_threads * 4;
+    vector<PatternChunk> chunks(num_chunks);
+    bool invalid = false;
+    // patterns of previous blocks must be merged with the new ones
+    bool merge = !empty();
+    // site_pattern first stores the local pattern index within the chunk
+    site_pattern.resize(end);
+
+    // 1. hash the sites of each chunk into a local table
+    #pragma omp parallel for schedule(dynamic) reduction(||:invalid)
+    for (int c = 0; c < num_chunks; ++c) {
+        PatternChunk &chunk = chunks[c];
+        PatternIntMap local_index;
+        size_t chunk_start = start + c * chunk_size;
+        size_t chunk_end = min(end, chunk_start + chunk_size);
+        Pattern pat;
+        pat.resize(nseq);
+        for (size_t site = chunk_start; site < chunk_end && !invalid; ++site) {
+            for (size_t seq = 0; seq < nseq; ++seq) {
+                StateType state = char_to_state[(int)(block[seq][site-offset])];
+                invalid = invalid || (state == STATE_INVALID);
+                pat[seq] = state;
+            }
+            auto res = local_index.emplace(pat, chunk.patterns.size());
+            if (res.second) {
+                chunk.patterns.push_back(pat);
+            } else {
+                chunk.patterns[res.first->second].frequency++;
+            }
+            site_pattern[site] = res.first->second;
+        }
+        hashPattern hasher;
+        size_t nptn = chunk.patterns.size();
+        chunk.hashes.resize(nptn);
+        for (size_t i = 0; i < nptn; ++i) {
+            chunk.hashes[i] = hasher(chunk.patterns[i]);
+        }
+        chunk.owner_chunk.resize(nptn);
+        chunk.owner_ptn.resize(nptn);
+        chunk.ptn_id.resize(nptn);
+        progress += (chunk_end - chunk_start);
+    }
+    if (invalid) {
+        // let the caller report the invalid characters site by site
+        site_pattern.resize(start);
+        return false;
+    }
+
+    // 2. merge the local tables in hash shards, visiting chunks in site order,
+    // so that the owner of a pattern is its first occurrence in the block
+    #pragma omp parallel for schedule(dynamic)
+    for (int shard = 0; shard < num_shards; ++shard) {
+        PatternIntMap shard_index;
+        IntVector owners; // pairs of owner chunk and local pattern index
+        for (int c = 0; c < num_chunks; ++c) {
+            PatternChunk &chunk = chunks[c];
+            for (int i = 0; i < chunk.patterns.size(); ++i) {
+                if ((int)(chunk.hashes[i] % num_shards) != shard) {
+                    continue;
+                }
+                auto res = shard_index.emplace(chunk.patterns[i], owners.size());
+                if (res.second) {
+                    owners.push_back(c);
+                    owners.push_back(i);
+                    chunk.owner_chunk[i] = c;
+                    chunk.owner_ptn[i] = i;
+                } else {
+                    int owner_chunk = owners[res.first->second];
+                    int owner_ptn = owners[res.first->second+1];
+                    chunk.owner_chunk[i] = owner_chunk;
+                    chunk.owner_ptn[i] = owner_ptn;
+                    chunks[owner_chunk].patterns[owner_ptn].frequency += chunk.patterns[i].frequency;
+                }
+            }
+        }
+    }
+
+    // 3. number the patterns in order of their first occurrence, as addPattern() does
+    for (int c = 0; c < num_chunks; ++c) {
+        PatternChunk &chunk = chunks[c];
+        for (int i = 0; i < chunk.patterns.size(); ++i) {
+            if (chunk.owner_chunk[i] != c || chunk.owner_ptn[i] != i) {
+                chunk.ptn_id[i] = chunks[chunk.owner_chunk[i]].ptn_id[chunk.owner_ptn[i]];
+                continue;
+            }
+            Pattern &pat = chunk.patterns[i];
+            if (pat.isGapOnly(STATE_UNKNOWN)) {
+                num_gaps_only += pat.frequency;
+            }
+            PatternIntMap::iterator it;
+            if (merge && (it = pattern_index.find(pat)) != pattern_index.end()) {
+                chunk.ptn_id[i] = it->second;
+                at(it->second).frequency += pat.frequency;
+                continue;
+            }
+            int ptn = size();
+            chunk.ptn_id[i] = ptn;
+            push_back(std::move(pat));
+            pattern_index[back()] = ptn;
+        }
+    }
+
+    // 4. translate local pattern indices of the sites
+    #pragma omp parallel for schedule(static)
+    for (int c = 0; c < num_chunks; ++c) {
+        size_t chunk_start = start + c * chunk_size;
+        size_t chunk_end = min(end, chunk_start + chunk_size);
+        for (size_t site = chunk_start; site < chunk_end; ++site) {
+            site_pattern[site] = chunks[c].ptn_id[site_pattern[site]];
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
 void Alignment::updateConstPatterns(size_t startPtn) {
     size_t nptn = size();
     #ifdef _OPENMP
@@ -1598,52 +1800,76 @@ void Alignment::regroupSitePattern(const IntVector &site_group) {
     }
 }
 
+/**
+	count the characters of the sequences
+	@param sequences vector of strings
+	@param[out] char_counts number of occurrences of each character
+*/
+static void countSeqChars(const StrVector &sequences, vector<size_t> &char_counts) {
+    char_counts.assign(NUM_CHAR, 0);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+        vector<size_t> counts(NUM_CHAR, 0);
+#ifdef _OPENMP
+#pragma omp for nowait
+#endif
+        for (size_t seq = 0; seq < sequences.size(); ++seq) {
+            for (unsigned char ch : sequences[seq]) {
+                counts[ch]++;
+            }
+        }
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+        for (int ch = 0; ch < NUM_CHAR; ++ch) {
+            char_counts[ch] += counts[ch];
+        }
+    }
+}
+
 /**
 	detect the data type of the input sequences
 	@param sequences vector of strings
 	@return the data type of the input sequences
 */
 SeqType Alignment::detectSequenceType(StrVector &sequences) {
+    vector<size_t> char_counts;
+    countSeqChars(sequences, char_counts);
+    return detectSequenceType(char_counts);
+}
+
+SeqType Alignment::detectSequenceType(const vector<size_t> &char_counts) {
     size_t num_proper_nuc = 0;
     size_t num_nuc   = 0;
     size_t num_aa    = 0;
     size_t num_bin   = 0;
     size_t num_digit = 0;
     size_t num_alpha = 0;
-    double detectStart = getRealTime();
-    size_t sequenceCount = sequences.size();
-    std::unordered_set<char> proper_nucleotides = {'A', 'C', 'G', 'T', 'U'};
-    std::unordered_set<char> nucleotides = {'A', 'C', 'G', 'T', 'U', 'R', 'Y', 'W', 'S', 'M', 'K', 'B', 'H', 'D', 'V', 'N', 'X'};
-    std::unordered_set<char> proper_amino_acids = {'A', 'R', 'N', 'D', 'C', 'Q', 'E', 'G', 'H', 'I', 'L', 'K', 'M', 'F', 'P', 'S',  'T', 'W', 'Y', 'V'};
-    std::unordered_set<char> binaries = {'0', '1'};
-//    std::unordered_set<char> gap_miss = {'?', '-', '.', '~'};
-    
-#ifdef _OPENMP
-#pragma omp parallel for reduction(+:num_proper_nuc, num_nuc, num_aa, num_bin, num_digit, num_alpha)
-#endif
-    for (size_t seqNum = 0; seqNum < sequenceCount; ++seqNum) {
-        auto start = sequences.at(seqNum).data();
-        auto stop  = start + sequences.at(seqNum).size();
-        for (auto i = start; i!=stop; ++i) {
-//            if (gap_miss.find(*i) != gap_miss.end()) {
-//                continue;
-//            }
-            if (proper_nucleotides.find(*i) != proper_nucleotides.end())
-                num_proper_nuc++;
-            if (nucleotides.find(*i) != nucleotides.end())
-                num_nuc++;
-            if (proper_amino_acids.find(*i) != proper_amino_acids.end())
-                num_aa++;
-            if (binaries.find(*i) != binaries.end())
-                num_bin++;
-            if (isdigit(*i))
-                num_digit++;
-            if (isalpha(*i))
-                num_alpha++;
+    const char *proper_nucleotides = "ACGTU";
+    const char *nucleotides = "ACGTURYWSMKBHDVNX";
+    const char *proper_amino_acids = "ARNDCQEGHILKMFPSTWYV";
+    const char *binaries = "01";
+
+    // characters beyond ASCII are neither letters nor digits
+    for (int ch = 1; ch < 128; ++ch) {
+        size_t count = char_counts[ch];
+        if (count == 0) {
+            continue;
         }
-    }
-    if (verbose_mode >= VB_MED) {
-        cout << "Sequence Type detection took " << (getRealTime()-detectStart) << " seconds." << endl;
+        if (strchr(proper_nucleotides, ch))
+            num_proper_nuc += count;
+        if (strchr(nucleotides, ch))
+            num_nuc += count;
+        if (strchr(proper_amino_acids, ch))
+            num_aa += count;
+        if (strchr(binaries, ch))
+            num_bin += count;
+        if (isdigit(ch))
+            num_digit += count;
+        if (isalpha(ch))
+            num_alpha += count;
     }
     if (num_digit == 0) {
         if (num_alpha < 10) // two few occurences to decide
@@ -2028,14 +2254,12 @@ int Alignment::getGeneticCodeId() {
     return found->second;
 }
 
-static int getMorphStates(const StrVector &sequences) {
+static int getMorphStates(const vector<size_t> &char_counts) {
     int nstate = 0;
     char maxstate = 0;
-    for (StrVector::const_iterator it = sequences.begin(); it != sequences.end(); ++it) {
-        for (string::const_iterator pos = it->begin(); pos != it->end(); ++pos) {
-            if (*pos > maxstate && isalnum(*pos)) {
-                maxstate = *pos;
-            }
+    for (int ch = 1; ch < 128; ++ch) {
+        if (char_counts[ch] > 0 && isalnum(ch)) {
+            maxstate = ch;
         }
     }
     if (maxstate >= '0' && maxstate <= '9') {
@@ -2092,7 +2316,49 @@ string Alignment::getSeqTypeStr(SeqType sequence_type) {
     }
 }
 
+/** reader of sequences kept in memory, returning them as a single block */
+class StrVectorBlockReader : public SeqBlockReader {
+public:
+    StrVectorBlockReader(StrVector &sequences) : sequences(sequences) {}
+
+    virtual void countChars(vector<size_t> &char_counts) {
+        countSeqChars(sequences, char_counts);
+    }
+
+    virtual size_t getBlockSize() {
+        return sequences.empty() ? 1 : max(sequences.front().length(), (size_t)1);
+    }
+
+    virtual StrVector &readBlock(size_t start, size_t end, size_t &offset) {
+        offset = 0;
+        return sequences;
+    }
+
+protected:
+    StrVector &sequences;
+};
+
 int Alignment::buildPattern(StrVector &sequences, char *sequence_type, int nseq, int nsite) {
+    if (nseq != seq_names.size()) {
+        throw "Different number of sequences than specified";
+    }
+    ostringstream err_str;
+    /* now check that all sequences have the same length */
+    for (size_t seq = 0; seq < nseq; ++seq) {
+        if (sequences[seq].length() != nsite) {
+            err_str << "Sequence " << seq_names[seq] << " contains "
+                    << ((sequences[seq].length() < nsite) ? "not enough" : "too many")
+                    << " characters (" << sequences[seq].length() << ")\n";
+        }
+    }
+    if (err_str.str() != "") {
+        throw err_str.str();
+    }
+    StrVectorBlockReader reader(sequences);
+    return buildPattern(reader, sequence_type, nseq, nsite);
+}
+
+int Alignment::buildPattern(SeqBlockReader &reader, char *sequence_type, int nseq, int nsite) {
     if (nseq != seq_names.size()) {
         throw "Different number of sequences than specified";
     }
@@ -2116,19 +2382,14 @@ int Alignment::buildPattern(StrVector &sequences, char *sequence_type, int nseq,
         cout.precision(6);
         cout << "Duplicate sequence name check took " << (getRealTime()-seqCheckStart) << " seconds." << endl;
     }
-    /* now check that all sequences have the same length */
-    for (size_t seq = 0; seq < nseq; ++seq) {
-        if (sequences[seq].length() != nsite) {
-            err_str << "Sequence " << seq_names[seq] << " contains "
-                    << ((sequences[seq].length() < nsite) ? "not enough" : "too many")
-                    << " characters (" << sequences[seq].length() << ")\n";
-        }
-    }
-    if (err_str.str() != "") {
-        throw err_str.str();
-    }
     /* now check data type */
-    seq_type = detectSequenceType(sequences);
+    double detectStart = getRealTime();
+    vector<size_t> char_counts;
+    reader.countChars(char_counts);
+    seq_type = detectSequenceType(char_counts);
+    if (verbose_mode >= VB_MED) {
+        cout << "Sequence Type detection took " << (getRealTime()-detectStart) << " seconds." << endl;
+    }
     switch (seq_type) {
     case SEQ_BINARY:
         num_states = 2;
@@ -2143,7 +2404,7 @@ int Alignment::buildPattern(StrVector &sequences, char *sequence_type, int nseq,
         cout << "Alignment most likely contains protein sequences" << endl;
         break;
     case SEQ_MORPH:
-        num_states = getMorphStates(sequences);
+        num_states = getMorphStates(char_counts);
         cout << "Alignment most likely contains " << num_states << "-state morphological data" << endl;
         break;
     case SEQ_POMO:
@@ -2167,7 +2428,7 @@ int Alignment::buildPattern(StrVector &sequences, char *sequence_type, int nseq,
             num_states = 20;
             user_seq_type = SEQ_PROTEIN;
         } else if (strcmp(sequence_type, "NUM") == 0 || strcmp(sequence_type, "MORPH") == 0) {
-            num_states = getMorphStates(sequences);
+            num_states = getMorphStates(char_counts);
             user_seq_type = SEQ_MORPH;
         } else if (strcmp(sequence_type, "TINA") == 0 || strcmp(sequence_type, "MULTI") == 0) {
             cout << "Multi-state data with " << num_states << " alphabets" << endl;
@@ -2216,45 +2477,67 @@ int Alignment::buildPattern(StrVector &sequences, char *sequence_type, int nseq,
     ASSERT(empty());
     int num_error = 0;
     int num_gaps_only = 0;
+    double pattern_start = getRealTime();
+    int pattern_threads = 1;
+    size_t block_size = reader.getBlockSize();
     progress_display progress(nsite, "Constructing alignment", "examined", "site");
-    for (size_t site = 0; site < nsite; site += step) {
-        Pattern pat;
-        for (size_t seq = 0; seq < nseq; ++seq) {
-            StateType state = char_to_state[(int)(sequences[seq][site])];
-            if (genetic_code) {
-                // special treatment for codon
-                StateType state2 = char_to_state[(int)(sequences[seq][site+1])];
-                StateType state3 = char_to_state[(int)(sequences[seq][site+2])];
-                state = getCodonStateTypeFromSites(state, state2, state3,
-                                                   AA_to_state,
-                                                   seq_names[seq], site,
-                                                   num_error);
-            }
-            if (state == STATE_INVALID) {
-                if (num_error < 100) {
-                    err_str << "Sequence " << seq_names[seq] << " has invalid character "
-                            << sequences[seq][site];
-                    if (step == 3) {
-                        err_str << sequences[seq][site+1] << sequences[seq][site+2];
+    for (size_t block_start = 0; block_start < nsite; block_start += block_size) {
+        size_t block_end = min((size_t)nsite, block_start + block_size);
+        size_t offset;
+        StrVector &sequences = reader.readBlock(block_start, block_end, offset);
+#ifdef _OPENMP
+        // codon sites and debug messages about gap-only sites are handled site by site
+        if (step == 1 && num_error == 0 && verbose_mode < VB_DEBUG && omp_get_max_threads() > 1 &&
+            (block_end - block_start) * nseq >= MIN_PARALLEL_PATTERN_CELLS &&
+            addPatternsParallel(sequences, offset, block_start, block_end, char_to_state, num_gaps_only, progress)) {
+            pattern_threads = omp_get_max_threads();
+            continue;
+        }
+#endif
+        for (size_t site = block_start; site < block_end; site += step) {
+            const size_t pos = site - offset;
+            Pattern pat;
+            for (size_t seq = 0; seq < nseq; ++seq) {
+                StateType state = char_to_state[(int)(sequences[seq][pos])];
+                if (genetic_code) {
+                    // special treatment for codon
+                    StateType state2 = char_to_state[(int)(sequences[seq][pos+1])];
+                    StateType state3 = char_to_state[(int)(sequences[seq][pos+2])];
+                    state = getCodonStateTypeFromSites(state, state2, state3,
+                                                       AA_to_state,
+                                                       seq_names[seq], site,
+                                                       num_error);
+                }
+                if (state == STATE_INVALID) {
+                    if (num_error < 100) {
+                        err_str << "Sequence " << seq_names[seq] << " has invalid character "
+                                << sequences[seq][pos];
+                        if (step == 3) {
+                            err_str << sequences[seq][pos+1] << sequences[seq][pos+2];
+                        }
+                        err_str << " at site " << site+1 << endl;
+                    } else if (num_error == 100) {
+                        err_str << "...many more..." << endl;
                     }
-                    err_str << " at site " << site+1 << endl;
-                } else if (num_error == 100) {
-                    err_str << "...many more..." << endl;
+                    num_error++;
                 }
-                num_error++;
+                pat.push_back(state);
             }
-            pat.push_back(state);
-        }
-        if (!num_error) {
-            bool gaps_only;
-            addPattern(pat, &gaps_only);
-            num_gaps_only += (gaps_only) ? 1 : 0;
+            if (!num_error) {
+                bool gaps_only;
+                addPattern(pat, &gaps_only);
+                num_gaps_only += (gaps_only) ? 1 : 0;
+            }
+            progress += step;
         }
-        progress += step;
     }
     progress.done();
     delete [] AA_to_state;
     updateConstPatterns();
+    if (verbose_mode >= VB_MED) {
+        cout << "Building " << size() << " site patterns took " << (getRealTime()-pattern_start) << " seconds"
+             << " using " << pattern_threads << " thread(s)." << endl;
+    }
     if (num_gaps_only) {
         cout << "WARNING: " << num_gaps_only << " sites contain only gaps or ambiguous characters." << endl;
     }
@@ -2264,6 +2547,203 @@ int Alignment::buildPattern(StrVector &sequences, char *sequence_type, int nseq,
     return 1;
 }
 
+template <class T>
+static void writeCacheValue(ostream &out, const T &value) {
+    out.write((const char*)&value, sizeof(T));
+}
+
+static void writeCacheString(ostream &out, const string &str) {
+    writeCacheValue(out, (uint64_t)str.length());
+    out.write(str.c_str(), str.length());
+}
+
+/**
+    sequential reader of a pattern cache file mapped into memory
+*/
+class PatternCacheReader {
+public:
+    PatternCacheReader(MappedFile &file) {
+        pos = file.getData();
+        end = pos + file.getSize();
+    }
+
+    /** @return the next len bytes of the file */
+    const char *read(size_t len) {
+        if ((size_t)(end - pos) < len) {
+            throw "Truncated pattern cache file";
+        }
+        const char *data = pos;
+        pos += len;
+        return data;
+    }
+
+    template <class T>
+    T readValue() {
+        T value;
+        memcpy(&value, read(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    string readString() {
+        uint64_t len = readValue<uint64_t>();
+        return string(read(len), len);
+    }
+
+protected:
+    const char *pos;
+    const char *end;
+};
+
+bool Alignment::readPatternCache(const string &cache_file, const string &key) {
+    MappedFile file;
+    if (!file.open(cache_file.c_str())) {
+        return false;
+    }
+    PatternCacheReader in(file);
+    try {
+        if (memcmp(in.read(sizeof(PATTERN_CACHE_MAGIC)), PATTERN_CACHE_MAGIC, sizeof(PATTERN_CACHE_MAGIC)) != 0 ||
+            in.readValue<uint32_t>() != PATTERN_CACHE_VERSION ||
+            in.readValue<uint32_t>() != PATTERN_CACHE_BYTE_ORDER ||
+            in.readValue<uint32_t>() != sizeof(StateType)) {
+            outWarning("Ignore incompatible pattern cache file " + cache_file);
+            return false;
+        }
+        if (in.readString() != key) {
+            // alignment file or reading options have changed
+            return false;
+        }
+        SeqType cache_seq_type = (SeqType)in.readValue<int32_t>();
+        int cache_num_states = in.readValue<int32_t>();
+        StateType cache_unknown = in.readValue<uint32_t>();
+        int code_id = in.readValue<int32_t>();
+        size_t nseq = in.readValue<uint64_t>();
+        seq_names.resize(nseq);
+        for (size_t seq = 0; seq < nseq; ++seq) {
+            seq_names[seq] = in.readString();
+        }
+        size_t nptn = in.readValue<uint64_t>();
+        size_t record_size = 4*sizeof(int32_t) + nseq*sizeof(StateType) + cache_num_states*sizeof(uint64_t);
+        if (nptn > SIZE_MAX / max(record_size, (size_t)1)) {
+            throw "Truncated pattern cache file";
+        }
+        const char *records = in.read(nptn * record_size);
+        size_t nsite = in.readValue<uint64_t>();
+        if (nsite > SIZE_MAX / sizeof(int32_t)) {
+            throw "Truncated pattern cache file";
+        }
+        const char *sites = in.read(nsite * sizeof(int32_t));
+        if (memcmp(in.read(sizeof(PATTERN_CACHE_MAGIC)), PATTERN_CACHE_MAGIC, sizeof(PATTERN_CACHE_MAGIC)) != 0) {
+            throw "Truncated pattern cache file";
+        }
+        resize(nptn);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (size_t ptn = 0; ptn < nptn; ++ptn) {
+            const char *record = records + ptn*record_size;
+            int32_t fields[4];
+            memcpy(fields, record, sizeof(fields));
+            Pattern &pat = at(ptn);
+            pat.frequency = fields[0];
+            pat.flag = fields[1];
+            pat.const_char = fields[2];
+            pat.num_chars = fields[3];
+            record += sizeof(fields);
+            pat.resize(nseq);
+            memcpy(&pat[0], record, nseq*sizeof(StateType));
+            record += nseq*sizeof(StateType);
+            pat.freqs.resize(cache_num_states);
+            for (int state = 0; state < cache_num_states; ++state) {
+                uint64_t freq;
+                memcpy(&freq, record + state*sizeof(uint64_t), sizeof(uint64_t));
+                pat.freqs[state] = freq;
+            }
+        }
+        site_pattern.resize(nsite);
+        memcpy(&site_pattern[0], sites, nsite*sizeof(int32_t));
+        pattern_index.clear();
+        for (size_t ptn = 0; ptn < nptn; ++ptn) {
+            pattern_index[at(ptn)] = ptn;
+        }
+        if (code_id) {
+            initCodon(convertIntToString(code_id).c_str());
+        }
+        seq_type = cache_seq_type;
+        num_states = cache_num_states;
+        STATE_UNKNOWN = cache_unknown;
+    } catch (const char *str) {
+        outWarning(string(str) + " " + cache_file);
+        clear();
+        seq_names.clear();
+        site_pattern.clear();
+        pattern_index.clear();
+        return false;
+    }
+    return true;
+}
+
+void Alignment::writePatternCache(const string &cache_file, const string &key) {
+    if (!MPIHelper::getInstance().isMaster()) {
+        return;
+    }
+    // also keep the genetic code of alignments translated to amino acids
+    int code_id = 0;
+    if (genetic_code) {
+        auto code_map = getGeneticCodeMap();
+        auto found = code_map.right.find(genetic_code);
+        if (found != code_map.right.end()) {
+            code_id = found->second;
+        }
+    }
+    size_t nseq = getNSeq();
+    string tmp_file = cache_file + ".tmp";
+    try {
+        ofstream out;
+        out.exceptions(ios::failbit | ios::badbit);
+        out.open(tmp_file.c_str(), ios::out | ios::binary);
+        out.write(PATTERN_CACHE_MAGIC, sizeof(PATTERN_CACHE_MAGIC));
+        writeCacheValue(out, PATTERN_CACHE_VERSION);
+        writeCacheValue(out, PATTERN_CACHE_BYTE_ORDER);
+        writeCacheValue(out, (uint32_t)sizeof(StateType));
+        writeCacheString(out, key);
+        writeCacheValue(out, (int32_t)seq_type);
+        writeCacheValue(out, (int32_t)num_states);
+        writeCacheValue(out, (uint32_t)STATE_UNKNOWN);
+        writeCacheValue(out, (int32_t)code_id);
+        writeCacheValue(out, (uint64_t)nseq);
+        for (size_t seq = 0; seq < nseq; ++seq) {
+            writeCacheString(out, seq_names[seq]);
+        }
+        writeCacheValue(out, (uint64_t)size());
+        vector<uint64_t> freqs(num_states);
+        for (iterator pat = begin(); pat != end(); ++pat) {
+            writeCacheValue(out, (int32_t)pat->frequency);
+            writeCacheValue(out, (int32_t)pat->flag);
+            writeCacheValue(out, (int32_t)pat->const_char);
+            writeCacheValue(out, (int32_t)pat->num_chars);
+            out.write((const char*)&(*pat)[0], nseq*sizeof(StateType));
+            for (int state = 0; state < num_states; ++state) {
+                freqs[state] = (state < pat->freqs.size()) ? pat->freqs[state] : 0;
+            }
+            out.write((const char*)&freqs[0], num_states*sizeof(uint64_t));
+        }
+        writeCacheValue(out, (uint64_t)site_pattern.size());
+        out.write((const char*)&site_pattern[0], site_pattern.size()*sizeof(int32_t));
+        out.write(PATTERN_CACHE_MAGIC, sizeof(PATTERN_CACHE_MAGIC));
+        out.close();
+    } catch (ios::failure &) {
+        outWarning("Cannot write pattern cache file " + cache_file);
+        remove(tmp_file.c_str());
+        return;
+    }
+    if (rename(tmp_file.c_str(), cache_file.c_str()) != 0) {
+        outWarning("Cannot write pattern cache file " + cache_file);
+        remove(tmp_file.c_str());
+        return;
+    }
+    cout << "Site patterns written to " << cache_file << endl;
+}
+
 void processSeq(string &sequence, string &line, int line_num) {
     int exclam_found = false;
     for (string::iterator it = line.begin(); it != line.end(); it++) {
@@ -2381,6 +2861,14 @@ void Alignment::doReadPhylip(char *filename, char *sequence_type, StrVector &seq
 int Alignment::readPhylip(char *filename, char *sequence_type) {
     StrVector sequences;
     int nseq = 0, nsite = 0;
+    bool tina_state = (sequence_type && (strcmp(sequence_type,"TINA") == 0 || strcmp(sequence_type,"MULTI") == 0));
+    MappedAlignmentFile mapped_file;
+    if (!tina_state && mapped_file.open(filename)) {
+        // tokenise the sequences in place without copying them
+        num_states = 0;
+        mapped_file.parsePhylip(false, seq_names, nseq, nsite);
+        return buildPattern(mapped_file, sequence_type, nseq, nsite);
+    }
     
     doReadPhylip(filename, sequence_type, sequences, nseq, nsite);
 
@@ -2459,6 +2947,13 @@ int Alignment::readPhylipSequential(char *filename, char *sequence_type) {
 
     StrVector sequences;
     int nseq = 0, nsite = 0;
+    MappedAlignmentFile mapped_file;
+    if (mapped_file.open(filename)) {
+        // tokenise the sequences in place without copying them
+        num_states = 0;
+        mapped_file.parsePhylip(true, seq_names, nseq, nsite);
+        return buildPattern(mapped_file, sequence_type, nseq, nsite);
+    }
     
     doReadPhylipSequential(filename, sequence_type, sequences, nseq, nsite);
 
@@ -2481,7 +2976,14 @@ int Alignment::readStrVec(StrVector &names, StrVector &seqs, char *sequence_type
         sequences.push_back(s);
     }
     
-    // now try to cut down sequence name if possible
+    shortenFastaSeqNames();
+    nseq = seq_names.size();
+    nsite = sequences.front().length();
+    
+    return buildPattern(sequences, sequence_type, nseq, nsite);
+}
+
+void Alignment::shortenFastaSeqNames() {
     int i, step = 0;
     StrVector new_seq_names, remain_seq_names;
     new_seq_names.resize(seq_names.size());
@@ -2493,7 +2995,9 @@ int Alignment::readStrVec(StrVector &names, StrVector &seqs, char *sequence_type
         unordered_set<string> namesSeenThisTime;
         //Set of shorted names seen so far, this iteration
         for (i = 0; i < seq_names.size(); i++) {
-            if (remain_seq_names[i].empty()) continue;
+            if (remain_seq_names[i].empty()) {
+                continue;
+            }
             size_t pos = remain_seq_names[i].find_first_of(" \t");
             if (pos == string::npos) {
                 new_seq_names[i] += remain_seq_names[i];
@@ -2509,23 +3013,23 @@ int Alignment::readStrVec(StrVector &names, StrVector &seqs, char *sequence_type
                 duplicated = !namesSeenThisTime.insert(new_seq_names[i]).second;
             }
         }
-        if (!duplicated) break;
+        if (!duplicated) {
+            break;
+        }
     }
     if (verbose_mode >= VB_MED) {
         cout.precision(6);
         cout << "Name shortening took " << (getRealTime() - startShorten) << " seconds." << endl;
     }
     if (step > 0) {
-        for (i = 0; i < seq_names.size(); i++)
+        for (i = 0; i < seq_names.size(); i++) {
             if (seq_names[i] != new_seq_names[i]) {
                 cout << "NOTE: Change sequence name '" << seq_names[i] << "' -> " << new_seq_names[i] << endl;
             }
+        }
     }
+
     seq_names = new_seq_names;
-    nseq = seq_names.size();
-    nsite = sequences.front().length();
-    
-    return buildPattern(sequences, sequence_type, nseq, nsite);
 }
 
 void Alignment::doReadFasta(char *filename, char *sequence_type, StrVector &sequences, int &nseq, int &nsite){
@@ -2577,53 +3081,7 @@ void Alignment::doReadFasta(char *filename, char *sequence_type, StrVector &sequ
     in.exceptions(ios::failbit | ios::badbit);
     in.close();
 
-    // now try to cut down sequence name if possible
-    int i, step = 0;
-    StrVector new_seq_names, remain_seq_names;
-    new_seq_names.resize(seq_names.size());
-    remain_seq_names = seq_names;
-
-    double startShorten = getRealTime();
-    for (step = 0; step < 4; step++) {
-        bool duplicated = false;
-        unordered_set<string> namesSeenThisTime;
-        //Set of shorted names seen so far, this iteration
-        for (i = 0; i < seq_names.size(); i++) {
-            if (remain_seq_names[i].empty()) {
-                continue;
-            }
-            size_t pos = remain_seq_names[i].find_first_of(" \t");
-            if (pos == string::npos) {
-                new_seq_names[i] += remain_seq_names[i];
-                remain_seq_names[i] = "";
-            } else {
-                new_seq_names[i] += remain_seq_names[i].substr(0, pos);
-                remain_seq_names[i] = "_" + remain_seq_names[i].substr(pos+1);
-            }
-            if (!duplicated) {
-                //add the shortened name for sequence i to the
-                //set of shortened names seen so far, and set
-                //duplicated to true if it was already there.
-                duplicated = !namesSeenThisTime.insert(new_seq_names[i]).second;
-            }
-        }
-        if (!duplicated) {
-            break;
-        }
-    }
-    if (verbose_mode >= VB_MED) {
-        cout.precision(6);
-        cout << "Name shortening took " << (getRealTime() - startShorten) << " seconds." << endl;
-    }
-    if (step > 0) {
-        for (i = 0; i < seq_names.size(); i++) {
-            if (seq_names[i] != new_seq_names[i]) {
-                cout << "NOTE: Change sequence name '" << seq_names[i] << "' -> " << new_seq_names[i] << endl;
-            }
-        }
-    }
-
-    seq_names = new_seq_names;
+    shortenFastaSeqNames();
     
     nseq = seq_names.size();
     nsite = sequences.front().length();
@@ -2634,6 +3092,14 @@ int Alignment::readFasta(char *filename, char *sequence_type) {
     StrVector sequences;
     int nseq = 0;
     int nsite = 0;
+    MappedAlignmentFile mapped_file;
+    if (mapped_file.open(filename)) {
+        // tokenise the sequences in place without copying them
+        mapped_file.parseFasta(seq_names, nseq, nsite);
+        shortenFastaSeqNames();
+        mapped_file.checkSeqLengths(seq_names, nsite);
+        return buildPattern(mapped_file, sequence_type, nseq, nsite);
+    }
     
     doReadFasta(filename, sequence_type, sequences, nseq, nsite);
     
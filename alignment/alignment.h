@@ -21,6 +21,9 @@
 const double MIN_FREQUENCY          = 0.0001;
 const double MIN_FREQUENCY_DIFF     = 0.00001;
 
+/** minimal number of sequences times sites to build site patterns with multiple threads */
+const size_t MIN_PARALLEL_PATTERN_CELLS = 1000000;
+
 const int NUM_CHAR = 256;
 typedef bitset<NUM_CHAR> StateBitset;
 
@@ -70,7 +73,6 @@ public:
 
 std::ostream& operator<< (std::ostream& stream, const SymTestResult& res);
 
-#ifdef USE_HASH_MAP
 struct hashPattern {
     size_t operator()(const Pattern &pat) const {
         size_t sum = 0;
@@ -80,6 +82,8 @@ struct hashPattern {
         return sum;
     }
 };
+
+#ifdef USE_HASH_MAP
 typedef unordered_map<Pattern, int, hashPattern> PatternIntMap;
 #else
 typedef map<Pattern, int> PatternIntMap;
@@ -90,6 +94,33 @@ constexpr int EXCLUDE_GAP   = 1; // exclude gaps
 constexpr int EXCLUDE_INVAR = 2; // exclude invariant sites
 constexpr int EXCLUDE_UNINF = 4; // exclude uninformative sites
 
+class progress_display;
+
+/**
+    source of the characters of the sequences, read in blocks of consecutive sites,
+    so that the sequences need not be kept in memory as a whole
+*/
+class SeqBlockReader {
+public:
+    virtual ~SeqBlockReader() {}
+
+    /**
+        count the characters of all sequences
+        @param[out] char_counts number of occurrences of each character
+    */
+    virtual void countChars(vector<size_t> &char_counts) = 0;
+
+    /** @return maximal number of sites of a block, a multiple of 3 */
+    virtual size_t getBlockSize() = 0;
+
+    /**
+        read the sites [start, end) of all sequences, blocks must be read in order of sites
+        @param[out] offset the character of site i of sequence j is block[j][i-offset]
+        @return the block of characters
+    */
+    virtual StrVector &readBlock(size_t start, size_t end, size_t &offset) = 0;
+};
+
 /**
 Multiple Sequence Alignment. Stored by a vector of site-patterns
 
@@ -164,6 +195,18 @@ public:
      */
     bool addPattern(const Pattern &pat, bool *gaps_only = nullptr);
 
+    /**
+     *  Add the patterns of sites [start, end) using multiple threads: chunks of sites are
+     *  hashed into local tables, which are then merged in hash shards.
+     *  The result is identical to calling addPattern() for each site in turn
+     *  @param block characters of the sites, block[seq][site-offset]
+     *  @param char_to_state mapping from characters to states
+     *  @param[in,out] num_gaps_only number of sites containing only gaps
+     *  @return FALSE if some site contains an invalid character, in which case nothing is added
+     */
+    bool addPatternsParallel(StrVector &block, size_t offset, size_t start, size_t end,
+                             char *char_to_state, int &num_gaps_only, progress_display &progress);
+
     /**
      *  Apply computeConst() to each pattern starting from startPtn index
      */
@@ -207,6 +250,29 @@ public:
     int readNexus(char *filename);
 
     int buildPattern(StrVector &sequences, char *sequence_type, int nseq, int nsite);
+
+    /**
+            build the patterns from sequences read block by block
+            @param reader source of the sequence characters
+            @param sequence_type type of the sequence, either "BIN", "DNA", "AA", or nullptr
+            @return 1 on success
+     */
+    int buildPattern(SeqBlockReader &reader, char *sequence_type, int nseq, int nsite);
+
+    /**
+            read the site patterns from a binary cache file written by writePatternCache()
+            @param cache_file cache file name
+            @param key checksum of the alignment file and reading options the patterns depend on
+            @return TRUE if the cache was built with the same key and was read, FALSE otherwise
+     */
+    bool readPatternCache(const string &cache_file, const string &key);
+
+    /**
+            write the site patterns, sequence names and data type into a binary cache file
+            @param cache_file cache file name
+            @param key checksum of the alignment file and reading options the patterns depend on
+     */
+    void writePatternCache(const string &cache_file, const string &key);
     
     /**
             do-read the alignment in PHYLIP format (interleaved)
@@ -257,6 +323,12 @@ public:
      */
     void doReadFasta(char *filename, char *sequence_type, StrVector &sequences, int &nseq, int &nsite);
 
+    /**
+            cut down the sequence names read from a FASTA file at the first white space
+            as long as the shortened names stay unique
+     */
+    void shortenFastaSeqNames();
+
     /**
             read the alignment in FASTA format
             @param filename file name
@@ -352,6 +424,13 @@ public:
      ****************************************************************************/
     SeqType detectSequenceType(StrVector &sequences);
 
+    /**
+            detect the data type from the number of occurrences of each character
+            @param char_counts number of occurrences of each character in the sequences
+            @return the data type of the sequences
+     */
+    SeqType detectSequenceType(const vector<size_t> &char_counts);
+
     void computeUnknownState();
 
     void buildStateMap(char *map) const;
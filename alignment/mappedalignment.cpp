@@ -0,0 +1,382 @@
+//
+//  mappedalignment.cpp
+//  alignment
+//
+//  Reader of PHYLIP and FASTA alignment files mapped into memory
+//
+
+#include "mappedalignment.h"
+#include "utils/progress.h" //for progress_display
+#include <zlib.h>
+
+#if !defined(WIN32) && !defined(WIN64)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define USE_MMAP
+#endif
+
+MappedFile::MappedFile() {
+    data = nullptr;
+    data_size = 0;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const char *filename) {
+#ifdef USE_MMAP
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < 2) {
+        ::close(fd);
+        return false;
+    }
+    void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    data = (char*)addr;
+    data_size = st.st_size;
+    madvise(data, data_size, MADV_SEQUENTIAL);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void MappedFile::close() {
+#ifdef USE_MMAP
+    if (data) {
+        munmap(data, data_size);
+    }
+#endif
+    data = nullptr;
+    data_size = 0;
+}
+
+uint32_t MappedFile::computeChecksum() {
+    size_t nchunk = (data_size + MAPPED_BLOCK_CHARS - 1) / MAPPED_BLOCK_CHARS;
+    vector<uLong> chunk_crc(nchunk);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (size_t chunk = 0; chunk < nchunk; ++chunk) {
+        const char *begin = data + chunk * MAPPED_BLOCK_CHARS;
+        const char *end = min(begin + MAPPED_BLOCK_CHARS, (const char*)data + data_size);
+        chunk_crc[chunk] = crc32(crc32(0L, Z_NULL, 0), (const Bytef*)begin, end - begin);
+        releasePages(begin, end);
+    }
+    uLong crc = crc32(0L, Z_NULL, 0);
+    for (size_t chunk = 0; chunk < nchunk; ++chunk) {
+        size_t len = min(MAPPED_BLOCK_CHARS, data_size - chunk * MAPPED_BLOCK_CHARS);
+        crc = crc32_combine(crc, chunk_crc[chunk], len);
+    }
+    return crc;
+}
+
+bool MappedAlignmentFile::open(const char *filename) {
+    if (!MappedFile::open(filename)) {
+        return false;
+    }
+    // gzip-compressed files are read as a stream
+    if ((unsigned char)data[0] == 0x1f && (unsigned char)data[1] == 0x8b) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+const char *MappedAlignmentFile::nextLine(const char *line, const char *&line_end) {
+    const char *file_end = data + data_size;
+    const char *pos = line;
+    while (pos < file_end && *pos != '\n' && *pos != '\r') {
+        pos++;
+    }
+    line_end = pos;
+    if (pos < file_end && *pos == '\r') {
+        pos++;
+        if (pos < file_end && *pos == '\n') {
+            pos++;
+        }
+    } else if (pos < file_end) {
+        pos++;
+    }
+    return pos;
+}
+
+size_t MappedAlignmentFile::scanSeqChars(const char *begin, const char *end, int line_num) {
+    size_t num_chars = 0;
+    bool exclam_found = false;
+    for (const char *it = begin; it != end; it++) {
+        if ((*it) <= ' ') {
+            continue;
+        }
+        if (isalnum(*it) || (*it) == '-' || (*it) == '?'|| (*it) == '.' || (*it) == '*' || (*it) == '~') {
+            char_counts[(unsigned char)toupper(*it)]++;
+        } else if ((*it) == '!') {
+            char_counts[(unsigned char)'!']++;
+            if (!exclam_found) {
+                exclam_found = true;
+                cout << "Warning: Line " + convertIntToString(line_num) + ": '!' was found in the alignment, which will be interpreted as a gap" << endl;
+            }
+        } else if (*it == '(' || *it == '{') {
+            const char *start_it = it;
+            while (it != end && *it != ')' && *it != '}') {
+                it++;
+            }
+            if (it == end) {
+                throw "Line " + convertIntToString(line_num) + ": No matching close-bracket ) or } found";
+            }
+            char_counts[(unsigned char)'?']++;
+            cout << "NOTE: Line " << line_num << ": " << string(start_it, it+1) << " is treated as unknown character" << endl;
+        } else {
+            throw "Line " + convertIntToString(line_num) + ": Unrecognized character "  + *it;
+        }
+        num_chars++;
+    }
+    return num_chars;
+}
+
+void MappedAlignmentFile::addSeqRange(int seq, const char *begin, const char *end) {
+    vector<SeqRange> &ranges = seq_ranges[seq];
+    if (!ranges.empty()) {
+        const char *pos = ranges.back().end;
+        while (pos < begin && (*pos) <= ' ') {
+            pos++;
+        }
+        if (pos == begin) {
+            ranges.back().end = end;
+            return;
+        }
+    }
+    ranges.push_back({begin, end});
+}
+
+void MappedAlignmentFile::parsePhylip(bool sequential, StrVector &seq_names, int &nseq, int &nsite) {
+    const char *file_end = data + data_size;
+    const char *line_end;
+    int seq_id = 0;
+    nseq = 0;
+    char_counts.assign(NUM_CHAR, 0);
+    const char *line = data;
+    const char *released = data;
+    for (int line_num = 1; line < file_end; line_num++) {
+        const char *next = nextLine(line, line_end);
+        if (line_end == line) {
+            line = next;
+            continue;
+        }
+        if (nseq == 0) { // read number of sequences and sites
+            istringstream line_in(string(line, line_end));
+            if (!(line_in >> nseq >> nsite)) {
+                throw "Invalid PHYLIP format. First line must contain number of sequences and sites";
+            }
+            if (nseq < 3) {
+                throw "There must be at least 3 sequences";
+            }
+            if (nsite < 1) {
+                throw "No alignment columns";
+            }
+            seq_names.resize(nseq, "");
+            seq_ranges.resize(nseq);
+            seq_lengths.resize(nseq, 0);
+        } else { // read sequence contents
+            if (sequential && seq_id >= nseq) {
+                throw "Line " + convertIntToString(line_num) + ": Too many sequences detected";
+            }
+            const char *seq_begin = line;
+            if (seq_names[seq_id] == "") { // cut out the sequence name
+                const char *pos = line;
+                while (pos < line_end && *pos != ' ' && *pos != '\t') {
+                    pos++;
+                }
+                if (pos == line_end) {
+                    pos = min(line + 10, line_end); //  assume standard phylip
+                }
+                seq_names[seq_id] = string(line, pos);
+                seq_begin = pos;
+            }
+            size_t num_chars = scanSeqChars(seq_begin, line_end, line_num);
+            if (num_chars > 0) {
+                addSeqRange(seq_id, seq_begin, line_end);
+            }
+            seq_lengths[seq_id] += num_chars;
+            if (sequential) {
+                if (seq_lengths[seq_id] > nsite) {
+                    throw ("Line " + convertIntToString(line_num) + ": Sequence " + seq_names[seq_id] + " is too long (" + convertIntToString(seq_lengths[seq_id]) + ")");
+                }
+                if (seq_lengths[seq_id] == nsite) {
+                    seq_id++;
+                }
+            } else {
+                if (seq_lengths[seq_id] != seq_lengths[0]) {
+                    ostringstream err_str;
+                    err_str << "Line " << line_num << ": Sequence " << seq_names[seq_id] << " has wrong sequence length " << seq_lengths[seq_id] << endl;
+                    throw err_str.str();
+                }
+                if (num_chars > 0) {
+                    seq_id++;
+                }
+                if (seq_id == nseq) {
+                    seq_id = 0;
+                }
+            }
+        }
+        line = next;
+        if (line - released >= MAPPED_BLOCK_CHARS) {
+            // the scanned part is read again only when building patterns
+            releasePages(released, line);
+            released = line;
+        }
+    }
+    checkSeqLengths(seq_names, nsite);
+}
+
+void MappedAlignmentFile::parseFasta(StrVector &seq_names, int &nseq, int &nsite) {
+    const char *file_end = data + data_size;
+    const char *line_end;
+    char_counts.assign(NUM_CHAR, 0);
+    const char *line = data;
+    const char *released = data;
+    {
+        progress_display progress(data_size, "Reading fasta file", "", "");
+        for (int line_num = 1; line < file_end; line_num++) {
+            const char *next = nextLine(line, line_end);
+            if (line_end == line) {
+                line = next;
+                continue;
+            }
+            if (*line == '>') { // next sequence
+                seq_names.push_back(string(line+1, line_end));
+                trimString(seq_names.back());
+                seq_ranges.resize(seq_names.size());
+                seq_lengths.push_back(0);
+                line = next;
+                continue;
+            }
+            // read sequence contents
+            if (seq_names.empty()) {
+                throw "First line must begin with '>' to define sequence name";
+            }
+            size_t num_chars = scanSeqChars(line, line_end, line_num);
+            if (num_chars > 0) {
+                addSeqRange(seq_names.size()-1, line, line_end);
+            }
+            seq_lengths.back() += num_chars;
+            progress = (double)(next - data);
+            line = next;
+            if (line - released >= MAPPED_BLOCK_CHARS) {
+                // the scanned part is read again only when building patterns
+                releasePages(released, line);
+                released = line;
+            }
+        }
+    }
+    if (seq_names.empty()) {
+        throw "No sequences found";
+    }
+    nseq = seq_names.size();
+    nsite = seq_lengths.front();
+}
+
+void MappedAlignmentFile::checkSeqLengths(StrVector &seq_names, int nsite) {
+    ostringstream err_str;
+    for (size_t seq = 0; seq < seq_names.size(); ++seq) {
+        if (seq_lengths[seq] != nsite) {
+            err_str << "Sequence " << seq_names[seq] << " contains "
+                    << ((seq_lengths[seq] < nsite) ? "not enough" : "too many")
+                    << " characters (" << seq_lengths[seq] << ")\n";
+        }
+    }
+    if (err_str.str() != "") {
+        throw err_str.str();
+    }
+}
+
+void MappedAlignmentFile::countChars(vector<size_t> &char_counts) {
+    char_counts = this->char_counts;
+}
+
+size_t MappedAlignmentFile::getBlockSize() {
+    size_t nseq = max(seq_ranges.size(), (size_t)1);
+    return max((size_t)3, MAPPED_BLOCK_CHARS / nseq / 3 * 3);
+}
+
+StrVector &MappedAlignmentFile::readBlock(size_t start, size_t end, size_t &offset) {
+    size_t nseq = seq_ranges.size();
+    size_t len = end - start;
+    offset = start;
+    if (start == 0) {
+        // the file was scanned by the parser, now it is read again block by block
+        releasePages(data, data + data_size);
+        cur_range.assign(nseq, 0);
+        cur_pos.resize(nseq);
+        for (size_t seq = 0; seq < nseq; ++seq) {
+            cur_pos[seq] = seq_ranges[seq].empty() ? nullptr : seq_ranges[seq][0].begin;
+        }
+    }
+    block.resize(nseq);
+    size_t low_pos = data_size;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(min:low_pos)
+#endif
+    for (size_t seq = 0; seq < nseq; ++seq) {
+        string &chars = block[seq];
+        chars.resize(len);
+        vector<SeqRange> &ranges = seq_ranges[seq];
+        size_t &range = cur_range[seq];
+        const char *pos = cur_pos[seq];
+        const char *release_from = pos;
+        size_t num_chars = 0;
+        while (num_chars < len) {
+            ASSERT(range < ranges.size());
+            if (pos == ranges[range].end) {
+                releasePages(release_from, pos);
+                range++;
+                ASSERT(range < ranges.size());
+                pos = release_from = ranges[range].begin;
+                continue;
+            }
+            char ch = *pos;
+            if (ch <= ' ') {
+                pos++;
+                continue;
+            }
+            if (ch == '(' || ch == '{') {
+                // ambiguous characters checked by scanSeqChars()
+                while (*pos != ')' && *pos != '}') {
+                    pos++;
+                }
+                ch = '?';
+            } else if (ch != '!') {
+                ch = toupper(ch);
+            }
+            chars[num_chars++] = ch;
+            pos++;
+        }
+        releasePages(release_from, pos);
+        cur_pos[seq] = pos;
+        low_pos = min(low_pos, (size_t)(pos - data));
+    }
+    // all sequences have read beyond low_pos (e.g. interleaved PHYLIP)
+    releasePages(data, data + low_pos);
+    return block;
+}
+
+void MappedFile::releasePages(const char *begin, const char *end) {
+#ifdef USE_MMAP
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    uintptr_t page_begin = ((uintptr_t)begin + page_size - 1) / page_size * page_size;
+    uintptr_t page_end = (uintptr_t)end / page_size * page_size;
+    if (page_begin < page_end) {
+        madvise((void*)page_begin, page_end - page_begin, MADV_DONTNEED);
+    }
+#endif
+}
@@ -0,0 +1,143 @@
+//
+//  mappedalignment.h
+//  alignment
+//
+//  Reader of PHYLIP and FASTA alignment files mapped into memory
+//
+
+#ifndef MAPPEDALIGNMENT_H
+#define MAPPEDALIGNMENT_H
+
+#include "utils/tools.h"
+#include "alignment.h"
+
+/** number of characters read into memory per block of sites */
+const size_t MAPPED_BLOCK_CHARS = 1 << 24;
+
+/**
+    read-only file mapped into memory
+*/
+class MappedFile {
+public:
+
+    MappedFile();
+
+    virtual ~MappedFile();
+
+    /**
+        map the file into memory
+        @param filename file name
+        @return FALSE if the file cannot be mapped, it must then be read as a stream
+    */
+    virtual bool open(const char *filename);
+
+    /** unmap the file */
+    void close();
+
+    /** @return CRC-32 checksum of the file content, computed in parallel chunks */
+    uint32_t computeChecksum();
+
+    /** mapped file content */
+    const char *getData() { return data; }
+
+    /** size of the mapped file */
+    size_t getSize() { return data_size; }
+
+protected:
+
+    /** let the system drop the pages of a range of the file from memory */
+    void releasePages(const char *begin, const char *end);
+
+    /** mapped file content */
+    char *data;
+
+    /** size of the mapped file */
+    size_t data_size;
+};
+
+/**
+    alignment file in PHYLIP or FASTA format mapped into memory.
+    The sequences are tokenised in place, keeping only the ranges of their characters
+    in the file, and are read block by block of sites when building the patterns,
+    so that the sequences are never copied into memory as a whole
+*/
+class MappedAlignmentFile : public MappedFile, public SeqBlockReader {
+public:
+
+    /**
+        map the file into memory
+        @param filename file name
+        @return FALSE if the file is compressed or cannot be mapped, it must then be read as a stream
+    */
+    virtual bool open(const char *filename);
+
+    /**
+        tokenise the file in PHYLIP format, checking the characters like processSeq()
+        @param sequential TRUE for sequential, FALSE for interleaved format
+        @param[out] seq_names sequence names
+        @param[out] nseq number of sequences
+        @param[out] nsite number of sites
+    */
+    void parsePhylip(bool sequential, StrVector &seq_names, int &nseq, int &nsite);
+
+    /**
+        tokenise the file in FASTA format, checking the characters like processSeq()
+        @param[out] seq_names full sequence names
+        @param[out] nseq number of sequences
+        @param[out] nsite number of sites of the first sequence
+    */
+    void parseFasta(StrVector &seq_names, int &nseq, int &nsite);
+
+    /** check that all sequences have nsite characters, called by parsePhylip() */
+    void checkSeqLengths(StrVector &seq_names, int nsite);
+
+    virtual void countChars(vector<size_t> &char_counts);
+
+    virtual size_t getBlockSize();
+
+    virtual StrVector &readBlock(size_t start, size_t end, size_t &offset);
+
+protected:
+
+    /** range of the file containing characters of a sequence, possibly spanning several lines */
+    struct SeqRange {
+        const char *begin;
+        const char *end;
+    };
+
+    /**
+        @param line beginning of a line
+        @param[out] line_end end of the line content
+        @return beginning of the next line, lines end with \n, \r\n or \r like safeGetline()
+    */
+    const char *nextLine(const char *line, const char *&line_end);
+
+    /**
+        check the sequence characters of a line and count them in char_counts
+        @return number of sequence characters in the line
+    */
+    size_t scanSeqChars(const char *begin, const char *end, int line_num);
+
+    /** append a range to a sequence, merged with the last range if only white spaces are in between */
+    void addSeqRange(int seq, const char *begin, const char *end);
+
+    /** character ranges of each sequence in file order */
+    vector<vector<SeqRange> > seq_ranges;
+
+    /** number of characters of each sequence */
+    vector<size_t> seq_lengths;
+
+    /** number of occurrences of each sequence character */
+    vector<size_t> char_counts;
+
+    /** current range of each sequence while reading blocks */
+    vector<size_t> cur_range;
+
+    /** current position of each sequence while reading blocks */
+    vector<const char*> cur_pos;
+
+    /** characters of the current block */
+    StrVector block;
+};
+
+#endif
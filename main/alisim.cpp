@@ -791,10 +791,11 @@ void generateMultipleAlignmentsFromSingleTree(AliSimulator *super_alisimulator,
     }
 #endif
 
-    // reset number of OpenMP threads to 1 in simulations with Indels
+    // reset number of OpenMP threads to 1 in simulations with Indels, only the Gillespie events on long sequences are simulated in parallel
     if (super_alisimulator->params->num_threads != 1 && super_alisimulator->params->alisim_insertion_ratio + super_alisimulator->params->alisim_deletion_ratio > 0)
     {
-        outWarning("OpenMP has not yet been supported in simulations with Indels. AliSim is now using a single thread for this simulation.");
+        outWarning("OpenMP has not yet been fully supported in simulations with Indels. AliSim is now using a single thread for this simulation, except for simulating events on segments of long sequences without rate heterogeneity.");
+        super_alisimulator->params->alisim_gillespie_threads = super_alisimulator->params->num_threads;
         super_alisimulator->params->num_threads = 1;
 #ifdef _OPENMP
         omp_set_num_threads(super_alisimulator->params->num_threads);
@@ -45,6 +45,7 @@
 #include "pda/splitgraph.h"
 #include "pda/circularnetwork.h"
 #include "tree/mtreeset.h"
+#include "tree/splitreader.h"
 #include "tree/mexttree.h"
 #include "ncl/ncl.h"
 #include "nclextra/msetsblock.h"
@@ -1412,6 +1413,43 @@ void computeRFDistSamePair(const char *trees1, const char *trees2, const char *f
     delete [] rfdist_raw;
 }
 
+/**
+    compute RF distances from splits read directly from the tree file(s), without building the trees
+    @return false if the tree file(s) must be read by MTreeSet
+*/
+bool computeRFDistSplits(Params &params, const char *filename) {
+    SplitReader reader;
+    bool two_sets = (params.rf_dist_mode == RF_TWO_TREE_SETS);
+    if (!reader.readTrees(params.user_file, params.is_rooted, params.tree_burnin, params.tree_max_count,
+            two_sets ? -1000 : params.split_weight_threshold))
+        return false;
+    int n = reader.tree_splits.size(), m = n;
+    double *rfdist;
+    if (two_sets) {
+        if (!reader.readTrees(params.second_tree, params.is_rooted, params.tree_burnin, params.tree_max_count))
+            return false;
+        cout << "Computing Robinson-Foulds distances between two sets of trees" << endl;
+        m = reader.tree_splits.size() - n;
+        rfdist = new double [(size_t)n*m];
+        memset(rfdist, 0, (size_t)n*m*sizeof(double));
+        MTreeSet::computeRFDist(reader.tree_splits, n, reader.num_trivial, reader.taxname.size(), false, rfdist);
+    } else {
+        // adjacent pairs only need one row
+        size_t size = (params.rf_dist_mode == RF_ADJACENT_PAIR) ? n : (size_t)n*n;
+        rfdist = new double [size];
+        memset(rfdist, 0, size*sizeof(double));
+        if (n >= 2) {
+            cout << "Computing Robinson-Foulds distance..." << endl;
+            if (verbose_mode >= VB_MED)
+                cout << reader.split_table.size() << " distinct splits in " << n << " trees" << endl;
+            MTreeSet::computeRFDist(reader.tree_splits, rfdist, params.rf_dist_mode);
+        }
+    }
+    printRFDist(filename, rfdist, n, m, params.rf_dist_mode);
+    delete [] rfdist;
+    return true;
+}
+
 void computeRFDist(Params &params) {
 
     if (!params.user_file) outError("User tree file not provided");
@@ -1429,6 +1467,11 @@ void computeRFDist(Params &params) {
         return;
     }
 
+    // the .rfinfo, .rftree and .incomp files of -v need the trees themselves
+    if ((params.rf_dist_mode != RF_TWO_TREE_SETS || verbose_mode < VB_MED) &&
+        computeRFDistSplits(params, filename.c_str()))
+        return;
+
     MTreeSet trees(params.user_file, params.is_rooted, params.tree_burnin, params.tree_max_count);
     int n = trees.size(), m = trees.size();
     double *rfdist;
@@ -1743,6 +1786,12 @@ outstreambuf* outstreambuf::close() {
 }
 
 int outstreambuf::overflow( int c) { // used for output buffer only
+    if (thread_out_buffer) {
+        // collect output of a concurrent analysis, printed later in one piece
+        if (c != EOF)
+            thread_out_buffer->push_back((char)c);
+        return c;
+    }
     if ((verbose_mode >= VB_MIN && MPIHelper::getInstance().isMaster()) || verbose_mode >= VB_MED)
         if (cout_buf->sputc(c) == EOF) return EOF;
     if (Params::getInstance().suppress_output_flags & OUT_LOG)
@@ -1756,6 +1805,8 @@ int outstreambuf::overflow( int c) { // used for output buffer only
 
 
 int outstreambuf::sync() { // used for output buffer only
+    if (thread_out_buffer)
+        return 0;
     if ((verbose_mode >= VB_MIN && MPIHelper::getInstance().isMaster()) || verbose_mode >= VB_MED)
         cout_buf->pubsync();
     if ((Params::getInstance().suppress_output_flags & OUT_LOG) || !MPIHelper::getInstance().isMaster())
@@ -2455,7 +2506,7 @@ int main(int argc, char *argv[]) {
     else
         cout << "auto-detect threads";
     cout << " (" << max_procs << " CPU cores detected)";
-    if (Params::getInstance().num_threads  > max_procs) {
+    if (getenv("IQ_NOCHECK") == nullptr && Params::getInstance().num_threads  > max_procs) {
         cout << endl;
         outError("You have specified more threads than CPU cores available");
     }
@@ -3300,7 +3351,7 @@ extern "C" StringResult simulate_alignment(const char* tree, const char* subst_m
         else
             cout << "auto-detect threads";
         cout << " (" << max_procs << " CPU cores detected)";
-        if (params.num_threads  > max_procs) {
+        if (getenv("IQ_NOCHECK") == nullptr && params.num_threads  > max_procs) {
             cout << endl;
             outError("You have specified more threads than CPU cores available.");
         }
@@ -3609,7 +3660,7 @@ char* build_phylogenetic(StringArray& cnames, StringArray& cseqs, const char* cm
     else
         cout << "auto-detect threads";
     cout << " (" << max_procs << " CPU cores detected)";
-    if (Params::getInstance().num_threads  > max_procs) {
+    if (getenv("IQ_NOCHECK") == nullptr && Params::getInstance().num_threads  > max_procs) {
         cout << endl;
         outError("You have specified more threads than CPU cores available");
     }
@@ -52,6 +52,7 @@
 #include "utils/stoprule.h"
 
 #include "tree/mtreeset.h"
+#include "tree/splitreader.h"
 #include "tree/mexttree.h"
 #include "model/ratemeyerhaeseler.h"
 #include "whtest/whtest_wrapper.h"
@@ -3607,7 +3608,13 @@ void runTreeReconstruction(Params &params, IQTree* &iqtree) {
         if (params.lh_mem_save == LM_MEM_SAVE && params.max_mem_size > total_mem)
             params.max_mem_size = total_mem;
 
-        uint64_t mem_required = iqtree->getMemoryRequired();
+        uint64_t mem_required = iqtree->getMemoryRequired() + iqtree->getSubtreeLhCacheMemory();
+
+        if (mem_required >= total_mem*0.95 && params.lh_cache_size > 0.0) {
+            // first give up the subtree likelihood cache
+            mem_required -= iqtree->getSubtreeLhCacheMemory();
+            params.lh_cache_size = 0.0;
+        }
 
         if (mem_required >= total_mem*0.95 && !iqtree->isSuperTree()) {
             // switch to memory saving mode
@@ -3903,6 +3910,14 @@ void runTreeReconstruction(Params &params, IQTree* &iqtree) {
 
     cout << "BEST SCORE FOUND : " << iqtree->getCurScore() << endl;
 
+    if (verbose_mode >= VB_MED) {
+        if (iqtree->isSuperTree()) {
+            for (auto part_tree : *(PhyloSuperTree*)iqtree)
+                part_tree->getModelFactory()->reportTransMatrixStats(cout);
+        } else
+            iqtree->getModelFactory()->reportTransMatrixStats(cout);
+    }
+
     if (params.write_candidate_trees) {
         printTrees(iqtree->getBestTrees(), params, ".imd_trees");
     }
@@ -4513,6 +4528,314 @@ void exhaustiveSearchGAMMAInvar(Params &params, IQTree &iqtree) {
 /**********************************************************
  * STANDARD NON-PARAMETRIC BOOTSTRAP
  ***********************************************************/
+
+/** number of patterns times states worth one thread when replicates run concurrently */
+const size_t BOOT_PATTERN_STATES_PER_THREAD = 4000;
+
+/**
+    @return TRUE if bootstrap replicates can run independently of each other with
+    runIndependentBootstrap(), i.e. they share no files or global state
+*/
+static bool isIndependentBootstrap(Params &params, IQTree *tree) {
+    Alignment *aln = tree->aln;
+    return !(aln->isSuperAlignment() || tree->isTreeMix() || tree->isMixlen() || params.num_mixlen > 1 ||
+        posRateHeterotachy(aln->model_name) != string::npos || params.pll || params.start_tree == STT_RANDOM_TREE ||
+        params.gbo_replicates > 0 ||
+        params.print_tree_lh || params.print_bootaln || params.print_boot_site_freq ||
+        params.lh_mem_save == LM_MEM_SAVE);
+}
+
+/**
+    decide how many bootstrap replicates to run concurrently, each with fewer threads
+    @param num_samples number of replicates still to run
+    @param[out] threads_per_boot number of threads for each replicate
+    @return number of concurrent replicates, 1 to run replicates one after another
+*/
+static int getNumConcurrentBootstraps(Params &params, IQTree *tree, int num_samples, int &threads_per_boot) {
+    threads_per_boot = params.num_threads;
+#ifdef _OPENMP
+    if (params.num_threads <= 1 || num_samples <= 1 || MPIHelper::getInstance().getNumProcesses() > 1)
+        return 1;
+    Alignment *aln = tree->aln;
+    if (!isIndependentBootstrap(params, tree))
+        return 1;
+    if (params.num_threads_per_boot > 0) {
+        threads_per_boot = min(params.num_threads_per_boot, params.num_threads);
+    } else {
+        size_t work = (size_t)aln->getNPattern() * aln->num_states;
+        threads_per_boot = (int)min((size_t)params.num_threads, max((size_t)1, work / BOOT_PATTERN_STATES_PER_THREAD));
+    }
+    int num_boots = min(params.num_threads / threads_per_boot, num_samples);
+    // every concurrent replicate needs its own partial likelihood vectors (assuming 4 rate categories)
+    uint64_t mem_required = (uint64_t)aln->getNSeq() * get_safe_upper_limit(aln->getNPattern())
+        * aln->num_states * 4 * sizeof(double) * (1.0 + params.lh_cache_size);
+    if (mem_required > 0)
+        num_boots = (int)min((uint64_t)num_boots, max((uint64_t)1, (uint64_t)(getMemorySize()*0.9) / mem_required));
+    if (num_boots <= 1)
+        threads_per_boot = params.num_threads;
+    return max(num_boots, 1);
+#else
+    return 1;
+#endif
+}
+
+/**
+    run one bootstrap replicate independently of other concurrent replicates,
+    with its own random stream, checkpoint, output prefix and screen output
+    @param sample replicate ID
+    @param num_threads number of threads for this replicate
+    @param[out] log screen output of the replicate
+    @return tree reconstructed from the bootstrap alignment
+*/
+static string runIndependentBootstrap(Params &params, Alignment *alignment, IQTree *tree,
+                                      int sample, int num_threads, string &log)
+{
+    thread_out_buffer = &log;
+#ifdef _OPENMP
+    omp_set_num_threads(num_threads);
+#endif
+    // the replicate uses the same stream as for creating its bootstrap sample
+    int *rstream;
+    init_random(params.ran_seed + sample, false, &rstream);
+    thread_randstream = rstream;
+
+    // files of the replicate must not clash with other replicates
+    Params boot_params = params;
+    string boot_prefix = string(params.out_prefix) + ".boot" + convertIntToString(sample+1);
+    boot_params.out_prefix = (char*)boot_prefix.c_str();
+    boot_params.num_threads = num_threads;
+    boot_params.suppress_output_flags |= OUT_TREEFILE | OUT_UNIQUESEQ;
+    // PLL keeps global state: use IQ-TREE parsimony kernel instead
+    if (boot_params.start_tree == STT_PLL_PARSIMONY)
+        boot_params.start_tree = STT_PARSIMONY;
+
+    cout << endl << "===> START " << RESAMPLE_NAME_UPPER << " REPLICATE NUMBER "
+            << sample + 1 << endl << endl;
+    cout << "Creating " << RESAMPLE_NAME << " alignment (seed: " << params.ran_seed+sample << ")..." << endl;
+    Alignment *bootstrap_alignment = new Alignment;
+    bootstrap_alignment->createBootstrapAlignment(alignment, nullptr, params.bootstrap_spec);
+
+    IQTree *boot_tree = new IQTree(bootstrap_alignment);
+    if (!tree->constraintTree.empty()) {
+        boot_tree->constraintTree.readConstraint(tree->constraintTree);
+    }
+    Checkpoint checkpoint;
+    boot_tree->setCheckpoint(&checkpoint);
+    boot_tree->num_precision = tree->num_precision;
+
+    runTreeReconstruction(boot_params, boot_tree);
+    stringstream ss;
+    boot_tree->printTree(ss);
+
+    bootstrap_alignment = boot_tree->aln;
+    delete boot_tree;
+    delete bootstrap_alignment;
+    remove((boot_prefix + ".mldist").c_str());
+    remove((boot_prefix + ".bionj").c_str());
+    remove((boot_prefix + ".parstree").c_str());
+
+    thread_randstream = nullptr;
+    finish_random(rstream);
+    thread_out_buffer = nullptr;
+    return ss.str();
+}
+
+/**
+    collect the replicates still to run, restoring finished ones from the checkpoint
+    @param boot_sample number of replicates already written to .boottrees
+    @param[out] boot_trees trees of finished replicates, empty for the others
+    @return IDs of the replicates still to run
+*/
+static IntVector getUnfinishedBootstraps(Params &params, Checkpoint *checkpoint, int boot_sample, vector<string> &boot_trees) {
+    int num_samples = params.num_bootstrap_samples;
+    boot_trees.resize(num_samples);
+    IntVector samples;
+    checkpoint->startStruct("bootTrees");
+    for (int sample = boot_sample; sample < num_samples; sample++)
+        if (!checkpoint->getString(convertIntToString(sample+1), boot_trees[sample]))
+            samples.push_back(sample);
+    checkpoint->endStruct();
+    if (samples.size() < num_samples - boot_sample)
+        cout << "CHECKPOINT: " << num_samples - boot_sample - samples.size()
+             << " more " << RESAMPLE_NAME << " replicates restored" << endl;
+    return samples;
+}
+
+/**
+    checkpoint a finished replicate under "bootTrees" and write all finished trees
+    to .boottrees in the order of replicates
+    @param sample replicate ID
+    @param tree_str tree of the replicate
+    @param[in,out] boot_trees trees of finished replicates
+    @param[in,out] boot_sample number of replicates written to .boottrees
+*/
+static void saveBootstrapTree(Params &params, Checkpoint *checkpoint, int sample, string &tree_str,
+                              vector<string> &boot_trees, int &boot_sample, string &boottrees_name)
+{
+    int num_samples = params.num_bootstrap_samples;
+    boot_trees[sample] = tree_str;
+    checkpoint->startStruct("bootTrees");
+    checkpoint->put(convertIntToString(sample+1), tree_str);
+    checkpoint->endStruct();
+    for (; boot_sample < num_samples && !boot_trees[boot_sample].empty(); boot_sample++) {
+        if (MPIHelper::getInstance().isMaster())
+        try {
+            ofstream tree_out;
+            tree_out.exceptions(ios::failbit | ios::badbit);
+            tree_out.open(boottrees_name.c_str(), ios_base::out | ios_base::app);
+            tree_out << boot_trees[boot_sample] << endl;
+            tree_out.close();
+        } catch (ios::failure) {
+            outError(ERR_WRITE_OUTPUT, boottrees_name);
+        }
+        checkpoint->erase(string("bootTrees") + CKP_SEP + convertIntToString(boot_sample+1));
+    }
+    checkpoint->put("bootSample", boot_sample);
+    checkpoint->putBool("finished", false);
+    checkpoint->dump(true);
+}
+
+/**
+    run the remaining bootstrap replicates concurrently. Finished replicates are
+    checkpointed under "bootTrees" and written to .boottrees in replicate order,
+    so that a killed run resumes only the unfinished replicates
+    @param boot_sample number of replicates already written to .boottrees
+    @return number of replicates done
+*/
+static int runConcurrentBootstraps(Params &params, Alignment *alignment, IQTree *tree, int boot_sample,
+                                   int num_boots, int threads_per_boot, string &boottrees_name)
+{
+    Checkpoint *checkpoint = tree->getCheckpoint();
+    vector<string> boot_trees;
+    IntVector samples = getUnfinishedBootstraps(params, checkpoint, boot_sample, boot_trees);
+
+    cout << endl << "Running " << num_boots << " " << RESAMPLE_NAME << " replicates concurrently with "
+         << threads_per_boot << " thread(s) each" << endl;
+
+#ifdef _OPENMP
+    int saved_max_active_levels = omp_get_max_active_levels();
+    omp_set_max_active_levels(2);
+#pragma omp parallel for schedule(dynamic) num_threads(num_boots)
+#endif
+    for (int i = 0; i < samples.size(); i++) {
+        int sample = samples[i];
+        string log;
+        string tree_str = runIndependentBootstrap(params, alignment, tree, sample, threads_per_boot, log);
+#ifdef _OPENMP
+#pragma omp critical (bootstrap)
+#endif
+        {
+            cout << log;
+            saveBootstrapTree(params, checkpoint, sample, tree_str, boot_trees, boot_sample, boottrees_name);
+        }
+    }
+#ifdef _OPENMP
+    omp_set_max_active_levels(saved_max_active_levels);
+#endif
+    ASSERT(boot_sample == params.num_bootstrap_samples);
+    return boot_sample;
+}
+
+#ifdef _IQTREE_MPI
+/**
+    run the remaining bootstrap replicates over MPI as a work queue. Each worker asks
+    the master for a replicate (BOOT_TREE_TAG), runs it on its own and returns the tree
+    with the next request; the master answers with the next unfinished replicate (BOOT_TAG),
+    or -1 to stop. Once the queue is empty, an idle worker takes over the replicate that has
+    been running longest on another worker, so that a stalled or lost worker does not hold
+    up .boottrees; the first tree returned for a replicate is kept.
+    The master only dispatches replicates and writes files.
+    @param boot_sample number of replicates already written to .boottrees
+    @return number of replicates done
+*/
+static int runMPIBootstraps(Params &params, Alignment *alignment, IQTree *tree, int boot_sample,
+                            string &boottrees_name)
+{
+    MPIHelper &mpi = MPIHelper::getInstance();
+    int num_procs = mpi.getNumProcesses();
+
+    if (mpi.isWorker()) {
+        // replicates run without the other processes
+        int proc_id = mpi.getProcessID();
+        string msg = "-1";
+        while (true) {
+            mpi.setNumProcesses(num_procs);
+            mpi.setProcessID(proc_id);
+            mpi.sendString(msg, PROC_MASTER, BOOT_TREE_TAG);
+            mpi.recvString(msg, PROC_MASTER, BOOT_TAG);
+            int sample = convert_int(msg.c_str());
+            if (sample < 0)
+                break;
+            mpi.setNumProcesses(1);
+            mpi.setProcessID(PROC_MASTER);
+            string log;
+            string tree_str = runIndependentBootstrap(params, alignment, tree, sample, params.num_threads, log);
+            if (verbose_mode >= VB_MED)
+                cout << log;
+            msg = convertIntToString(sample) + " " + tree_str;
+        }
+        return params.num_bootstrap_samples;
+    }
+
+    Checkpoint *checkpoint = tree->getCheckpoint();
+    vector<string> boot_trees;
+    IntVector samples = getUnfinishedBootstraps(params, checkpoint, boot_sample, boot_trees);
+    int num_remain = samples.size();
+    int next = 0;
+    // replicate running on each worker with its start time, -1 if none
+    IntVector worker_sample(num_procs, -1);
+    DoubleVector worker_start(num_procs, 0.0);
+    // whether an idle worker already took over a replicate
+    BoolVector taken_over(params.num_bootstrap_samples, false);
+
+    cout << endl << "Distributing " << num_remain << " " << RESAMPLE_NAME << " replicates to "
+         << num_procs-1 << " MPI worker(s)" << endl;
+
+    for (int stopped = 0; stopped < num_procs-1; ) {
+        string msg;
+        int worker = mpi.recvString(msg, MPI_ANY_SOURCE, BOOT_TREE_TAG);
+        size_t pos = msg.find(' ');
+        int sample = convert_int(msg.substr(0, pos).c_str());
+        if (sample >= 0) {
+            worker_sample[worker] = -1;
+            if (boot_trees[sample].empty()) {
+                string tree_str = msg.substr(pos+1);
+                cout << RESAMPLE_NAME_UPPER << " replicate " << sample+1 << " finished by process " << worker
+                     << " (" << getRealTime() - worker_start[worker] << " sec)" << endl;
+                saveBootstrapTree(params, checkpoint, sample, tree_str, boot_trees, boot_sample, boottrees_name);
+                num_remain--;
+            }
+        }
+        // pick the next unfinished replicate for this worker
+        int next_sample = -1;
+        for (; next < samples.size() && next_sample < 0; next++)
+            if (boot_trees[samples[next]].empty())
+                next_sample = samples[next];
+        if (next_sample < 0 && num_remain > 0) {
+            int oldest = -1;
+            for (int w = 1; w < num_procs; w++)
+                if (worker_sample[w] >= 0 && !taken_over[worker_sample[w]] && boot_trees[worker_sample[w]].empty() &&
+                    (oldest < 0 || worker_start[w] < worker_start[oldest]))
+                    oldest = w;
+            if (oldest >= 0) {
+                next_sample = worker_sample[oldest];
+                taken_over[next_sample] = true;
+                cout << "Process " << worker << " takes over " << RESAMPLE_NAME << " replicate "
+                     << next_sample+1 << " from process " << oldest << endl;
+            }
+        }
+        worker_sample[worker] = next_sample;
+        worker_start[worker] = getRealTime();
+        msg = convertIntToString(next_sample);
+        mpi.sendString(msg, worker, BOOT_TAG);
+        if (next_sample < 0)
+            stopped++;
+    }
+    ASSERT(boot_sample == params.num_bootstrap_samples);
+    return boot_sample;
+}
+#endif
+
 void runStandardBootstrap(Params &params, Alignment *alignment, IQTree *tree) {
     ModelCheckpoint *model_info = new ModelCheckpoint;
     StrVector removed_seqs, twin_seqs;
@@ -4570,7 +4893,22 @@ void runStandardBootstrap(Params &params, Alignment *alignment, IQTree *tree) {
     
     // 2018-06-21: bug fix: alignment might be changed by -m ...MERGE
     alignment = tree->aln;
-    
+
+    // run replicates concurrently if each replicate cannot use all threads efficiently
+    int threads_per_boot;
+    int num_boots = getNumConcurrentBootstraps(params, tree, params.num_bootstrap_samples - bootSample, threads_per_boot);
+    if (num_boots > 1) {
+        bootSample = runConcurrentBootstraps(params, alignment, tree, bootSample, num_boots,
+                                             threads_per_boot, boottrees_name);
+    }
+#ifdef _IQTREE_MPI
+    // distribute replicates to MPI processes that pull the next one when idle
+    if (MPIHelper::getInstance().getNumProcesses() > 1 && isIndependentBootstrap(params, tree)) {
+        bootSample = runMPIBootstraps(params, alignment, tree, bootSample, boottrees_name);
+        MPIHelper::getInstance().barrier();
+    }
+#endif
+
     // do bootstrap analysis
     for (int sample = bootSample; sample < params.num_bootstrap_samples; sample++) {
         cout << endl << "===> START " << RESAMPLE_NAME_UPPER << " REPLICATE NUMBER "
@@ -6124,10 +6462,17 @@ void computeConsensusTree(const char *input_trees, int burnin, int max_count,
          }*/
         scale /= sg.maxWeight();
     } else {
-        boot_trees.init(input_trees, rooted, burnin, max_count,
-                tree_weight_file);
-        boot_trees.convertSplits(sg, cutoff, SW_COUNT, weight_threshold);
-        scale /= boot_trees.sumTreeWeights();
+        // unweighted trees are converted into splits without building the trees
+        SplitReader reader;
+        if (!tree_weight_file && reader.readTrees(input_trees, rooted, burnin, max_count)) {
+            reader.convertSplits(sg, cutoff, weight_threshold);
+            scale /= reader.tree_splits.size();
+        } else {
+            boot_trees.init(input_trees, rooted, burnin, max_count,
+                    tree_weight_file);
+            boot_trees.convertSplits(sg, cutoff, SW_COUNT, weight_threshold);
+            scale /= boot_trees.sumTreeWeights();
+        }
         cout << sg.size() << " splits found" << endl;
     }
     //sg.report(cout);
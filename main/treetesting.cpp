@@ -1075,6 +1075,101 @@ void performAUTest(Params &params, PhyloTree *tree, double *pattern_lhs, vector<
 }
 
 
+/** number of trees per thread evaluated in one batch by evaluateTrees */
+const size_t TREE_BATCH_PER_THREAD = 4;
+
+double evaluateTestTree(string &tree_str, Params &params, PhyloTree *tree, double *pattern_lh, string &tree_out) {
+    stringstream in(tree_str);
+    tree->freeNode();
+    tree->readTree(in, tree->rooted);
+    if (!tree->findNodeName(tree->aln->getSeqName(0))) {
+        outError("Taxon " + tree->aln->getSeqName(0) + " not found in tree");
+    }
+
+    if (tree->rooted && tree->getModelFactory()->isReversible()) {
+        if (tree->leafNum != tree->aln->getNSeq()+1)
+            outError("Tree does not have same number of taxa as alignment");
+        tree->convertToUnrooted();
+//            cout << "convertToUnrooted" << endl;
+    } else if (!tree->rooted && !tree->getModelFactory()->isReversible()) {
+        if (tree->leafNum != tree->aln->getNSeq())
+            outError("Tree does not have same number of taxa as alignment");
+        tree->convertToRooted();
+//            cout << "convertToRooted" << endl;
+    }
+    tree->setAlignment(tree->aln);
+    tree->setRootNode(params.root);
+    if (tree->isSuperTree())
+        ((PhyloSuperTree*) tree)->mapTrees();
+
+    tree->initializeAllPartialLh();
+    tree->fixNegativeBranch(false);
+    if (params.fixed_branch_length) {
+        tree->setCurScore(tree->computeLikelihood());
+    } else if (params.topotest_optimize_model) {
+        tree->getModelFactory()->optimizeParameters(BRLEN_OPTIMIZE, false, params.modelEps);
+        tree->setCurScore(tree->computeLikelihood());
+    } else {
+        tree->setCurScore(tree->optimizeAllBranches(100, 0.001));
+    }
+    stringstream out;
+    tree->printTree(out);
+    tree_out = out.str();
+
+    if (pattern_lh) {
+        double curScore = tree->getCurScore();
+        memset(pattern_lh, 0, get_safe_upper_limit(tree->getAlnNPattern())*sizeof(double));
+        tree->computePatternLikelihood(pattern_lh, &curScore);
+    }
+    return tree->getCurScore();
+}
+
+/**
+    create one copy of \a tree per thread for evaluating several trees concurrently
+    @param ntrees number of trees to evaluate
+    @param tree_copies [OUT] tree copies sharing the model of tree, empty if trees
+    should be evaluated one after another
+ */
+static void createTestTreeCopies(Params &params, IQTree *tree, size_t ntrees, vector<PhyloTree*> &tree_copies) {
+#ifdef _OPENMP
+    int nthreads = min((size_t)params.num_threads, ntrees);
+    if (nthreads <= 1)
+        return;
+    // tree copies share the model, which therefore must stay fixed
+    if (params.topotest_optimize_model || tree->isSuperTree() || tree->isMixlen() || tree->isTreeMix())
+        return;
+    if (!tree->getModel()->useRevKernel() || params.lh_mem_save == LM_MEM_SAVE)
+        return;
+    // copies must not take more than half of the RAM
+    uint64_t mem_copy = tree->getMemoryRequired();
+    nthreads = min((uint64_t)nthreads, getMemorySize() / 2 / max(mem_copy, (uint64_t)1));
+    if (nthreads <= 1)
+        return;
+    for (int i = 0; i < nthreads; i++) {
+        PhyloTree *tree_copy = new PhyloTree(tree->aln);
+        tree_copy->copyPhyloTree(tree, true);
+        tree_copy->setParams(&params);
+        tree_copy->sse = tree->sse;
+        tree_copy->optimize_by_newton = tree->optimize_by_newton;
+        tree_copy->setNumThreads(1);
+        tree_copy->setModelFactory(tree->getModelFactory());
+        tree_copies.push_back(tree_copy);
+    }
+#endif
+}
+
+/**
+    free tree copies created by createTestTreeCopies
+ */
+static void deleteTestTreeCopies(vector<PhyloTree*> &tree_copies) {
+    for (auto tree_copy : tree_copies) {
+        // model is owned by the original tree
+        tree_copy->setModelFactory(nullptr);
+        delete tree_copy;
+    }
+    tree_copies.clear();
+}
+
 void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &info, IntVector &distinct_ids)
 {
     cout << endl;
@@ -1188,92 +1283,116 @@ void evaluateTrees(istream &in, Params &params, IQTree *tree, vector<TreeInfo> &
     info.resize(ntrees);
     string saved_tree;
     saved_tree = tree->getTreeString();
+
+    // evaluate batches of trees concurrently on thread-private tree copies
+    vector<PhyloTree*> tree_copies;
+    createTestTreeCopies(params, tree, ntrees, tree_copies);
+    size_t batch_size = (tree_copies.empty()) ? 1 : tree_copies.size() * TREE_BATCH_PER_THREAD;
+    if (!tree_copies.empty())
+        cout << "Evaluating trees in batches of " << batch_size << " with " << tree_copies.size() << " threads" << endl;
+    vector<string> batch_trees, batch_outs;
+    IntVector batch_index;
+    DoubleVector batch_logl;
+    double *batch_ptn_lh = nullptr;
+    if (pattern_lh && !tree_copies.empty())
+        batch_ptn_lh = aligned_alloc<double>(batch_size*maxnptn);
+
     //for (MTreeSet::iterator it = trees.begin(); it != trees.end(); it++, tree_index++) {
-    for (tree_index = 0, tid = 0; tree_index < distinct_ids.size(); tree_index++) {
-        
-        cout << "Tree " << tree_index + 1;
-        if (distinct_ids[tree_index] >= 0) {
-            cout << " / identical to tree " << distinct_ids[tree_index]+1 << endl;
-            // ignore tree
+    for (tree_index = 0, tid = 0; tree_index < distinct_ids.size(); ) {
+
+        // collect the next batch of distinct trees
+        batch_trees.clear();
+        batch_index.clear();
+        for (; tree_index < distinct_ids.size() && batch_trees.size() < batch_size; tree_index++) {
+            batch_index.push_back(tree_index);
+            string tree_str;
             char ch;
-            do {
-                in >> ch;
-            } while (!in.eof() && ch != ';');
-            continue;
-        }
-        tree->freeNode();
-        tree->readTree(in, tree->rooted);
-        if (!tree->findNodeName(tree->aln->getSeqName(0))) {
-            outError("Taxon " + tree->aln->getSeqName(0) + " not found in tree");
-        }
-        
-        if (tree->rooted && tree->getModelFactory()->isReversible()) {
-            if (tree->leafNum != tree->aln->getNSeq()+1)
-                outError("Tree does not have same number of taxa as alignment");
-            tree->convertToUnrooted();
-//            cout << "convertToUnrooted" << endl;
-        } else if (!tree->rooted && !tree->getModelFactory()->isReversible()) {
-            if (tree->leafNum != tree->aln->getNSeq())
-                outError("Tree does not have same number of taxa as alignment");
-            tree->convertToRooted();
-//            cout << "convertToRooted" << endl;
+            while (in.get(ch)) {
+                tree_str += ch;
+                if (ch == ';') break;
+            }
+            // ignore identical tree
+            batch_trees.push_back((distinct_ids[tree_index] >= 0) ? "" : tree_str);
         }
-        tree->setAlignment(tree->aln);
-        tree->setRootNode(params.root);
-        if (tree->isSuperTree())
-            ((PhyloSuperTree*) tree)->mapTrees();
-        
-        tree->initializeAllPartialLh();
-        tree->fixNegativeBranch(false);
-        if (params.fixed_branch_length) {
-            tree->setCurScore(tree->computeLikelihood());
-        } else if (params.topotest_optimize_model) {
-            tree->getModelFactory()->optimizeParameters(BRLEN_OPTIMIZE, false, params.modelEps);
-            tree->setCurScore(tree->computeLikelihood());
+        batch_outs.resize(batch_trees.size());
+        batch_logl.resize(batch_trees.size());
+
+        if (tree_copies.empty()) {
+            for (size_t i = 0; i < batch_trees.size(); i++)
+                if (!batch_trees[i].empty()) {
+                    batch_logl[i] = evaluateTestTree(batch_trees[i], params, tree, pattern_lh, batch_outs[i]);
+                }
         } else {
-            tree->setCurScore(tree->optimizeAllBranches(100, 0.001));
-        }
-        treeout << "[ tree " << tree_index+1 << " lh=" << tree->getCurScore() << " ]";
-        tree->printTree(treeout);
-        treeout << endl;
-        if (params.print_tree_lh)
-            scoreout << tree->getCurScore() << endl;
-        
-        cout << " / LogL: " << tree->getCurScore() << endl;
-        
-        if (pattern_lh) {
-            double curScore = tree->getCurScore();
-            memset(pattern_lh, 0, maxnptn*sizeof(double));
-            tree->computePatternLikelihood(pattern_lh, &curScore);
-            if (params.do_weighted_test || params.do_au_test)
-                memcpy(pattern_lhs + tid*maxnptn, pattern_lh, maxnptn*sizeof(double));
-        }
-        if (params.print_site_lh) {
-            string tree_name = "Tree" + convertIntToString(tree_index+1);
-            printSiteLh(site_lh_file.c_str(), tree, pattern_lh, true, tree_name.c_str());
-        }
-        if (params.print_partition_lh) {
-            string tree_name = "Tree" + convertIntToString(tree_index+1);
-            printPartitionLh(part_lh_file.c_str(), tree, pattern_lh, true, tree_name.c_str());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(tree_copies.size())
+#endif
+            for (size_t i = 0; i < batch_trees.size(); i++)
+                if (!batch_trees[i].empty()) {
+#ifdef _OPENMP
+                    PhyloTree *tree_copy = tree_copies[omp_get_thread_num()];
+#else
+                    PhyloTree *tree_copy = tree_copies[0];
+#endif
+                    double *ptn_lh = (batch_ptn_lh) ? batch_ptn_lh + i*maxnptn : nullptr;
+                    batch_logl[i] = evaluateTestTree(batch_trees[i], params, tree_copy, ptn_lh, batch_outs[i]);
+                }
         }
-        info[tid].logl = tree->getCurScore();
-        
-        if (!params.topotest_replicates || ntrees <= 1) {
+
+        // collect results in input order
+        for (size_t i = 0; i < batch_trees.size(); i++) {
+            int index = batch_index[i];
+            cout << "Tree " << index + 1;
+            if (distinct_ids[index] >= 0) {
+                cout << " / identical to tree " << distinct_ids[index]+1 << endl;
+                continue;
+            }
+            double logl = batch_logl[i];
+            treeout << "[ tree " << index+1 << " lh=" << logl << " ]";
+            treeout << batch_outs[i];
+            treeout << endl;
+            if (params.print_tree_lh)
+                scoreout << logl << endl;
+
+            cout << " / LogL: " << logl << endl;
+
+            if (batch_ptn_lh)
+                memcpy(pattern_lh, batch_ptn_lh + i*maxnptn, maxnptn*sizeof(double));
+            if (pattern_lh) {
+                if (params.do_weighted_test || params.do_au_test)
+                    memcpy(pattern_lhs + tid*maxnptn, pattern_lh, maxnptn*sizeof(double));
+            }
+            if (params.print_site_lh) {
+                string tree_name = "Tree" + convertIntToString(index+1);
+                printSiteLh(site_lh_file.c_str(), tree, pattern_lh, true, tree_name.c_str());
+            }
+            if (params.print_partition_lh) {
+                string tree_name = "Tree" + convertIntToString(index+1);
+                printPartitionLh(part_lh_file.c_str(), tree, pattern_lh, true, tree_name.c_str());
+            }
+            info[tid].logl = logl;
+
+            if (!params.topotest_replicates || ntrees <= 1) {
+                tid++;
+                continue;
+            }
+            // now compute RELL scores
+            orig_tree_lh[tid] = logl;
+            double *tree_lhs_offset = tree_lhs + (tid*params.topotest_replicates);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (!tree_copies.empty())
+#endif
+            for (size_t boot = 0; boot < params.topotest_replicates; boot++) {
+                double lh = 0.0;
+                int *this_boot_sample = boot_samples + (boot*nptn);
+                for (size_t ptn = 0; ptn < nptn; ptn++)
+                    lh += pattern_lh[ptn] * this_boot_sample[ptn];
+                tree_lhs_offset[boot] = lh;
+            }
             tid++;
-            continue;
         }
-        // now compute RELL scores
-        orig_tree_lh[tid] = tree->getCurScore();
-        double *tree_lhs_offset = tree_lhs + (tid*params.topotest_replicates);
-        for (size_t boot = 0; boot < params.topotest_replicates; boot++) {
-            double lh = 0.0;
-            int *this_boot_sample = boot_samples + (boot*nptn);
-            for (size_t ptn = 0; ptn < nptn; ptn++)
-                lh += pattern_lh[ptn] * this_boot_sample[ptn];
-            tree_lhs_offset[boot] = lh;
-        }
-        tid++;
     }
+    aligned_free(batch_ptn_lh);
+    deleteTestTreeCopies(tree_copies);
     
     ASSERT(tid == ntrees);
     
@@ -101,6 +101,17 @@ void printSiteStateFreq(const char* filename, Alignment *aln);
 */
 void printAncestralSequences(const char*filename, PhyloTree *tree, AncestralSeqType ast);
 
+/**
+ * Read a tree into \a tree and optimize its branch lengths (or model parameters)
+ * @param tree_str NEWICK string of the tree
+ * @param params program parameters
+ * @param tree tree object used for the evaluation
+ * @param pattern_lh (OUT) pattern log-likelihoods, can be nullptr
+ * @param tree_out (OUT) NEWICK string of the optimized tree
+ * @return log-likelihood of the tree
+ */
+double evaluateTestTree(string &tree_str, Params &params, PhyloTree *tree, double *pattern_lh, string &tree_out);
+
 /**
  * Evaluate user-trees with possibility of tree topology tests
  * @param params program parameters
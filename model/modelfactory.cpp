@@ -133,6 +133,8 @@ ModelFactory::ModelFactory() : CheckpointFactory() {
     site_rate = nullptr;
     store_trans_matrix = false;
     is_storing = false;
+    trans_matrix_version = -1;
+    trans_matrix_lookups = trans_matrix_hits = 0;
     joint_optimize = false;
     fused_mix_rate = false;
     ASC_type = ASC_NONE;
@@ -153,6 +155,8 @@ size_t findCloseBracket(string &str, size_t start_pos) {
 ModelFactory::ModelFactory(Params &params, string &model_name, PhyloTree *tree, ModelsBlock *models_block) : CheckpointFactory() {
     store_trans_matrix = params.store_trans_matrix;
     is_storing = false;
+    trans_matrix_version = -1;
+    trans_matrix_lookups = trans_matrix_hits = 0;
     joint_optimize = params.optimize_model_rate_joint;
     fused_mix_rate = false;
     ASC_type = ASC_NONE;
@@ -1763,13 +1767,36 @@ void ModelFactory::startStoringTransMatrix() {
 void ModelFactory::stopStoringTransMatrix() {
     if (!store_trans_matrix) return;
     is_storing = false;
-    if (!empty()) {
-        for (iterator it = begin(); it != end(); it++)
-            delete it->second;
-        clear();
-    }
+    clearTransMatrix();
+}
+
+void ModelFactory::clearTransMatrix() {
+    for (iterator it = begin(); it != end(); it++)
+        delete [] it->second;
+    clear();
+}
+
+double *ModelFactory::findTransMatrix(const TransMatrixKey &key) {
+    trans_matrix_lookups++;
+    if (trans_matrix_version != ModelSubst::decomposition_version) {
+        // model parameters changed
+        clearTransMatrix();
+        trans_matrix_version = ModelSubst::decomposition_version;
+        return nullptr;
+    }
+    iterator ass_it = find(key);
+    if (ass_it == end())
+        return nullptr;
+    trans_matrix_hits++;
+    return ass_it->second;
 }
 
+void ModelFactory::reportTransMatrixStats(ostream &out) {
+    if (trans_matrix_lookups == 0)
+        return;
+    out << "Stored transition matrices: " << trans_matrix_hits << " hits in " << trans_matrix_lookups
+        << " lookups (" << 100.0 * trans_matrix_hits / trans_matrix_lookups << "%)" << endl;
+}
 
 double ModelFactory::computeTrans(double time, int state1, int state2) {
     return model->computeTrans(time, state1, state2);
@@ -1780,24 +1807,35 @@ double ModelFactory::computeTrans(double time, int state1, int state2, double &d
 }
 
 void ModelFactory::computeTransMatrix(double time, double *trans_matrix, int mixture, int selected_row) {
-    if (!store_trans_matrix || !is_storing || model->isSiteSpecificModel()) {
+    if (!store_trans_matrix || !is_storing || selected_row >= 0 || model->isSiteSpecificModel()) {
         model->computeTransMatrix(time, trans_matrix, mixture, selected_row);
         return;
     }
     int mat_size = model->num_states * model->num_states;
-    iterator ass_it = find(round(time * 1e6));
-    if (ass_it == end()) {
-        // allocate memory for 3 matricies
-        double *trans_entry = new double[mat_size * 3];
-        trans_entry[mat_size] = trans_entry[mat_size+1] = 0.0;
-        model->computeTransMatrix(time, trans_entry, mixture, selected_row);
-        ass_it = insert(value_type(round(time * 1e6), trans_entry)).first;
-    } else {
-        //if (verbose_mode >= VB_MAX)
-            //cout << "ModelFactory bingo" << endl;
+    TransMatrixKey key(time, mixture);
+    bool found = false;
+    #pragma omp critical(trans_matrix)
+    {
+        double *trans_entry = findTransMatrix(key);
+        if (trans_entry) {
+            memcpy(trans_matrix, trans_entry, mat_size * sizeof(double));
+            found = true;
+        }
+    }
+    if (found)
+        return;
+    model->computeTransMatrix(time, trans_matrix, mixture);
+    // allocate memory for 3 matricies
+    double *trans_entry = new double[mat_size * 3];
+    memcpy(trans_entry, trans_matrix, mat_size * sizeof(double));
+    trans_entry[mat_size] = trans_entry[mat_size+1] = 0.0;
+    #pragma omp critical(trans_matrix)
+    {
+        if ((size()+1) * mat_size * 3 * sizeof(double) > MAX_TRANS_MATRIX_MEM)
+            clearTransMatrix();
+        if (!insert(value_type(key, trans_entry)).second)
+            delete [] trans_entry;
     }
-
-    memcpy(trans_matrix, ass_it->second, mat_size * sizeof(double));
 }
 
 void ModelFactory::computeTransDerv(double time, double *trans_matrix,
@@ -1807,27 +1845,43 @@ void ModelFactory::computeTransDerv(double time, double *trans_matrix,
         return;
     }
     int mat_size = model->num_states * model->num_states;
-    iterator ass_it = find(round(time * 1e6));
-    if (ass_it == end()) {
-        // allocate memory for 3 matricies
-        double *trans_entry = new double[mat_size * 3];
-        trans_entry[mat_size] = trans_entry[mat_size+1] = 0.0;
-        model->computeTransDerv(time, trans_entry, trans_entry+mat_size, trans_entry+(mat_size*2), mixture);
-        ass_it = insert(value_type(round(time * 1e6), trans_entry)).first;
-    } else if (ass_it->second[mat_size] == 0.0 && ass_it->second[mat_size+1] == 0.0) {
-        double *trans_entry = ass_it->second;
-        model->computeTransDerv(time, trans_entry, trans_entry+mat_size, trans_entry+(mat_size*2), mixture);
-    }
-    memcpy(trans_matrix, ass_it->second, mat_size * sizeof(double));
-    memcpy(trans_derv1, ass_it->second + mat_size, mat_size * sizeof(double));
-    memcpy(trans_derv2, ass_it->second + (mat_size*2), mat_size * sizeof(double));
+    TransMatrixKey key(time, mixture);
+    bool found = false;
+    #pragma omp critical(trans_matrix)
+    {
+        double *trans_entry = findTransMatrix(key);
+        // derivatives are not stored if the first two entries of the 1st derivative are zero
+        if (trans_entry && (trans_entry[mat_size] != 0.0 || trans_entry[mat_size+1] != 0.0)) {
+            memcpy(trans_matrix, trans_entry, mat_size * sizeof(double));
+            memcpy(trans_derv1, trans_entry + mat_size, mat_size * sizeof(double));
+            memcpy(trans_derv2, trans_entry + (mat_size*2), mat_size * sizeof(double));
+            found = true;
+        }
+    }
+    if (found)
+        return;
+    model->computeTransDerv(time, trans_matrix, trans_derv1, trans_derv2, mixture);
+    double *trans_entry = new double[mat_size * 3];
+    memcpy(trans_entry, trans_matrix, mat_size * sizeof(double));
+    memcpy(trans_entry + mat_size, trans_derv1, mat_size * sizeof(double));
+    memcpy(trans_entry + (mat_size*2), trans_derv2, mat_size * sizeof(double));
+    #pragma omp critical(trans_matrix)
+    {
+        iterator ass_it = find(key);
+        if (ass_it != end()) {
+            delete [] ass_it->second;
+            ass_it->second = trans_entry;
+        } else {
+            if ((size()+1) * mat_size * 3 * sizeof(double) > MAX_TRANS_MATRIX_MEM)
+                clearTransMatrix();
+            insert(value_type(key, trans_entry));
+        }
+    }
 }
 
 ModelFactory::~ModelFactory()
 {
-    for (iterator it = begin(); it != end(); it++)
-        delete it->second;
-    clear();
+    clearTransMatrix();
 }
 
 /************* FOLLOWING SERVE FOR JOINT OPTIMIZATION OF MODEL AND RATE PARAMETERS *******/
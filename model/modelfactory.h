@@ -54,14 +54,27 @@ string::size_type posRateFree(string &model_name);
 */
 string::size_type posPOMO(string &model_name);
 
+/** key of a stored transition matrix: evolutionary time and mixture class */
+typedef pair<double, int> TransMatrixKey;
+
+struct TransMatrixKeyHash {
+    size_t operator()(const TransMatrixKey &key) const {
+        return std::hash<double>()(key.first) ^ ((size_t)key.second * 0x9e3779b9);
+    }
+};
+
+/** maximal memory in bytes of transition matrices stored by ModelFactory */
+const size_t MAX_TRANS_MATRIX_MEM = 64*1024*1024;
+
 /**
 Store the transition matrix corresponding to evolutionary time so that one must not compute again. 
 For efficiency purpose esp. for protein (20x20) or codon (61x61).
-The values of the map contain 3 matricies consecutively: transition matrix, 1st, and 2nd derivative
+The values of the map contain 3 matricies consecutively: transition matrix, 1st, and 2nd derivative.
+Stored matrices are discarded once the rate matrix of any model is decomposed again.
 
 	@author BUI Quang Minh <minh.bui@univie.ac.at>
 */
-class ModelFactory : public unordered_map<int, double*>, public Optimization, public CheckpointFactory
+class ModelFactory : public unordered_map<TransMatrixKey, double*, TransMatrixKeyHash>, public Optimization, public CheckpointFactory
 {
 public:
 
@@ -139,6 +152,12 @@ public:
 	*/
 	void stopStoringTransMatrix();
 
+	/**
+		print the number of lookups and hits of stored transition matrices
+		@param out output stream
+	*/
+	void reportTransMatrixStats(ostream &out);
+
 	/**
 		Wrapper for computing the transition probability matrix from the model. It use ModelFactory
 		that stores matrix computed before for effiency purpose.
@@ -241,6 +260,16 @@ public:
 		TRUE for storing process
 	*/
 	bool is_storing;
+
+	/**
+		ModelSubst::decomposition_version when the stored transition matrices were computed
+	*/
+	int64_t trans_matrix_version;
+
+	/**
+		number of lookups and hits of stored transition matrices
+	*/
+	int64_t trans_matrix_lookups, trans_matrix_hits;
     
     /**
         TRUE for continuous Gamma
@@ -320,6 +349,17 @@ protected:
 
     vector<double> optimizeGammaInvWithInitValue(int fixed_len, double logl_epsilon, double gradient_epsilon,
                                        double initPInv, double initAlpha, DoubleVector &lenvec, Checkpoint *model_ckp);
+
+	/**
+		look up a stored transition matrix, discarding all stored matrices if any model has been
+		decomposed since they were computed. Must be called inside critical section trans_matrix
+		@param key evolutionary time and mixture class
+		@return pointer to the stored matrices, nullptr if not found
+	*/
+	double *findTransMatrix(const TransMatrixKey &key);
+
+	/** delete all stored transition matrices */
+	void clearTransMatrix();
     
 };
 
@@ -478,18 +478,23 @@ void ModelMarkov::computeTransMatrixNonrev(double time, double *trans_matrix, in
         ASSERT(maxcoeff < 1.001 && mincoeff > 0.999);
         trans_mat = mat;
     } else if (phylo_tree->params->matrix_exp_technique == MET_EIGEN3LIB_DECOMPOSITION) {
-        VectorXcd ceval_exp(num_states);
-        ArrayXcd eval = Map<ArrayXcd,Aligned>(ceval, num_states);
-        ceval_exp = (eval*time).exp().matrix();
+        // complex buffers on the stack to avoid heap-allocated temporaries
+        double ceval_exp_buf[2*num_states];
+        double scratch_buf[2*num_states*num_states];
+        double res_buf[2*num_states*num_states];
+        Map<VectorXcd> ceval_exp((complex<double>*)ceval_exp_buf, num_states);
+        ceval_exp = (Map<ArrayXcd,Aligned>(ceval, num_states)*time).exp().matrix();
         Map<MatrixXcd,Aligned> cevectors(cevec, num_states, num_states);
         Map<MatrixXcd,Aligned> cinv_evectors(cinv_evec, num_states, num_states);
-        MatrixXcd res = cevectors * ceval_exp.asDiagonal() * cinv_evectors;
+        Map<MatrixXcd> scratch((complex<double>*)scratch_buf, num_states, num_states);
+        Map<MatrixXcd> res((complex<double>*)res_buf, num_states, num_states);
+        scratch.noalias() = cevectors * ceval_exp.asDiagonal();
+        res.noalias() = scratch * cinv_evectors;
         Map<Matrix<double,Dynamic,Dynamic,RowMajor> >map_trans(trans_matrix,num_states,num_states);
         map_trans = res.real();
         // sanity check rows sum to 1
-        VectorXd row_sum = map_trans.rowwise().sum();
-        double mincoeff = row_sum.minCoeff();
-        double maxcoeff = row_sum.maxCoeff();
+        double mincoeff = map_trans.rowwise().sum().minCoeff();
+        double maxcoeff = map_trans.rowwise().sum().maxCoeff();
         if (maxcoeff > 1.0001 || mincoeff < 0.9999) {
             if (verbose_mode >= VB_MED)
                 cout << "INFO: Switch to scaling-squaring due to unstable eigen-decomposition rowsum: "
@@ -522,14 +527,17 @@ void ModelMarkov::computeTransMatrix(double time, double *trans_matrix, int mixt
                               , inv_eigenvectors_transposed, num_states, trans_matrix, selected_row);
         return;
     } else {
-        VectorXd eval_exp(num_states);
-        ArrayXd eval = Map<ArrayXd,Aligned>(eigenvalues, num_states);
-        eval_exp = (eval*evol_time).exp().matrix();
+        // buffers on the stack to avoid heap-allocated temporaries
+        double eval_exp_buf[num_states];
+        double scratch_buf[num_states*num_states];
+        Map<VectorXd> eval_exp(eval_exp_buf, num_states);
+        eval_exp = (Map<ArrayXd,Aligned>(eigenvalues, num_states)*evol_time).exp().matrix();
         Map<Matrix<double,Dynamic,Dynamic,RowMajor>,Aligned> evectors(eigenvectors, num_states, num_states);
         Map<Matrix<double,Dynamic,Dynamic,RowMajor>,Aligned> inv_evectors(inv_eigenvectors, num_states, num_states);
-        MatrixXd res = evectors * eval_exp.asDiagonal() * inv_evectors;
+        Map<Matrix<double,Dynamic,Dynamic,RowMajor> > scratch(scratch_buf, num_states, num_states);
         Map<Matrix<double,Dynamic,Dynamic,RowMajor> >map_trans(trans_matrix,num_states,num_states);
-        map_trans = res;
+        scratch.noalias() = evectors * eval_exp.asDiagonal();
+        map_trans.noalias() = scratch * inv_evectors;
         return;
     }
 #else
@@ -737,14 +745,12 @@ void ModelMarkov::computeTransDerv(double time, double *trans_matrix,
         // First derivative = Q * e^(Qt)
         Map<Matrix<double, Dynamic, Dynamic, RowMajor> > trans_mat(trans_matrix, num_states, num_states);
         Map<Matrix<double, Dynamic, Dynamic, RowMajor> > rate_mat(rate_matrix, num_states, num_states);
-        MatrixXd prod = rate_mat * trans_mat;
         Map<Matrix<double, Dynamic, Dynamic, RowMajor> > derv1_mat(trans_derv1, num_states, num_states);
-        derv1_mat = prod;
+        derv1_mat.noalias() = rate_mat * trans_mat;
 
         // Second derivative = Q * Q * e^(Qt)
-        prod = rate_mat * prod;
         Map<Matrix<double, Dynamic, Dynamic, RowMajor> > derv2_mat(trans_derv2, num_states, num_states);
-        derv2_mat = prod;
+        derv2_mat.noalias() = rate_mat * derv1_mat;
 
         /*
         for (int i = 0; i < num_states; i++)
@@ -789,24 +795,30 @@ void ModelMarkov::computeTransDerv(double time, double *trans_matrix,
     }
     else
     {
-        //EIGEN version
-        ArrayXd eval = Map<ArrayXd,Aligned>(eigenvalues, num_states);
-        ArrayXd eval_exp = (eval*evol_time).exp();
-        ArrayXd eval_exp_derv1 = eval_exp*eval;
-        ArrayXd eval_exp_derv2 = eval_exp_derv1*eval;
+        //EIGEN version, with buffers on the stack to avoid heap-allocated temporaries
+        double eval_exp_buf[num_states*3];
+        double scratch_buf[num_states*num_states];
+        Map<ArrayXd,Aligned> eval(eigenvalues, num_states);
+        Map<ArrayXd> eval_exp(eval_exp_buf, num_states);
+        Map<ArrayXd> eval_exp_derv1(eval_exp_buf+num_states, num_states);
+        Map<ArrayXd> eval_exp_derv2(eval_exp_buf+2*num_states, num_states);
+        eval_exp = (eval*evol_time).exp();
+        eval_exp_derv1 = eval_exp*eval;
+        eval_exp_derv2 = eval_exp_derv1*eval;
         Map<Matrix<double,Dynamic,Dynamic,RowMajor>,Aligned> evectors(eigenvectors, num_states, num_states);
         Map<Matrix<double,Dynamic,Dynamic,RowMajor>,Aligned> inv_evectors(inv_eigenvectors, num_states, num_states);
-        MatrixXd res = evectors * eval_exp.matrix().asDiagonal() * inv_evectors;
+        Map<Matrix<double,Dynamic,Dynamic,RowMajor> > scratch(scratch_buf, num_states, num_states);
         Map<Matrix<double,Dynamic,Dynamic,RowMajor> >map_trans(trans_matrix,num_states,num_states);
-        map_trans = res;
+        scratch.noalias() = evectors * eval_exp.matrix().asDiagonal();
+        map_trans.noalias() = scratch * inv_evectors;
         
-        res = evectors * eval_exp_derv1.matrix().asDiagonal() * inv_evectors;
         Map<Matrix<double,Dynamic,Dynamic,RowMajor> >map_derv1(trans_derv1,num_states,num_states);
-        map_derv1 = res;
+        scratch.noalias() = evectors * eval_exp_derv1.matrix().asDiagonal();
+        map_derv1.noalias() = scratch * inv_evectors;
         
-        res = evectors * eval_exp_derv2.matrix().asDiagonal() * inv_evectors;
         Map<Matrix<double,Dynamic,Dynamic,RowMajor> >map_derv2(trans_derv2,num_states,num_states);
-        map_derv2 = res;
+        scratch.noalias() = evectors * eval_exp_derv2.matrix().asDiagonal();
+        map_derv2.noalias() = scratch * inv_evectors;
     }
 #else
      //Flat version
@@ -1389,6 +1401,9 @@ void ModelMarkov::decomposeRateMatrixNonrev() {
 void ModelMarkov::decomposeRateMatrix(){
 	int i, j, k = 0;
 
+    #pragma omp atomic
+    decomposition_version++;
+
     if (!is_reversible) {
         decomposeRateMatrixNonrev();
         return;
@@ -12,6 +12,8 @@
 #include "modelsubst.h"
 #include "utils/tools.h"
 
+int64_t ModelSubst::decomposition_version = 0;
+
 ModelSubst::ModelSubst(int nstates) : Optimization(), CheckpointFactory()
 {
 	num_states = nstates;
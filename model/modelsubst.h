@@ -43,6 +43,12 @@ public:
 	*/
     ModelSubst(int nstates);
 
+	/**
+		incremented whenever the rate matrix of any model is decomposed,
+		such that ModelFactory can discard transition matrices computed before
+	*/
+	static int64_t decomposition_version;
+
 
 	/**
 		@return the number of dimensions
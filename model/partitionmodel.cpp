@@ -827,8 +827,9 @@ double PartitionModel::optimizeParameters(int fixed_len, bool write_info, double
     for (int step = 0; step < Params::getInstance().model_opt_steps; step++) {
         tree_lh = 0.0;
         if (tree->part_order.empty()) tree->computePartitionOrder();
+        tree->startPartitionLoop();
 #ifdef _OPENMP
-#pragma omp parallel for reduction(+: tree_lh) schedule(dynamic) if(tree->num_threads > 1)
+#pragma omp parallel for reduction(+: tree_lh) schedule(dynamic) num_threads(tree->num_threads) if(tree->num_threads > 1)
 #endif
         for (int i = 0; i < ntrees; i++) {
             int part = tree->part_order[i];
@@ -858,6 +859,7 @@ double PartitionModel::optimizeParameters(int fixed_len, bool write_info, double
                 << " / LogL: " << score << endl;
             }
         }
+        tree->endPartitionLoop();
         //return ModelFactory::optimizeParameters(fixed_len, write_info);
         
         if (!isLinkedModel())
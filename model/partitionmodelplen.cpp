@@ -100,8 +100,9 @@ double PartitionModelPlen::optimizeParameters(int fixed_len, bool write_info, do
     for(i = 1; i < tree->params->num_param_iterations; i++){
         cur_lh = 0.0;
         if (tree->part_order.empty()) tree->computePartitionOrder();
+        tree->startPartitionLoop();
 #ifdef _OPENMP
-#pragma omp parallel for reduction(+: cur_lh) schedule(dynamic) if(tree->num_threads > 1)
+#pragma omp parallel for reduction(+: cur_lh) schedule(dynamic) num_threads(tree->num_threads) if(tree->num_threads > 1)
 #endif
         for (int partid = 0; partid < ntrees; partid++) {
             int part = tree->part_order[partid];
@@ -125,6 +126,7 @@ double PartitionModelPlen::optimizeParameters(int fixed_len, bool write_info, do
             }
             
         }
+        tree->endPartitionLoop();
         if (tree->params->link_alpha) {
             cur_lh = optimizeLinkedAlpha(write_info, gradient_epsilon);
         }
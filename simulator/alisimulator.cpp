@@ -2817,21 +2817,60 @@ void AliSimulator::initVariables4RateMatrix(int segment_start, double &total_sub
 */
 void AliSimulator::simulateSeqByGillespie(int segment_start, int &segment_length, ModelSubst *model, vector<short int> &node_seq_chunk, int &sequence_length, NeighborVec::iterator it, SIMULATION_METHOD simulation_method, std::vector<bool>* const site_locked_vec, const int& total_predefined_mutation_count, int *rstream, default_random_engine& generator)
 {
-    int predefined_mutation_count = total_predefined_mutation_count;
-    int num_gaps = 0;
+    // dummy variables
+    int ori_seq_length = node_seq_chunk.size();
+    Insertion* insertion_before_simulation = latest_insertion;
+    
+    double branch_length = (*it)->length * params->alisim_branch_scale * partition_rate;
+    int num_segments = getNumGillespieSegments(sequence_length, site_locked_vec, total_predefined_mutation_count);
+    if (num_segments > 1)
+        simulateSeqByParallelGillespie(num_segments, model, node_seq_chunk, sequence_length, it, simulation_method, branch_length, rstream, generator);
+    else
+    {
+        // If AliSim is using TRANS_PROB_MATRIX approach -> only count the number of gaps, RATE_MATRIX approach counts them itself
+        int num_gaps = (*it)->node->sequence->num_gaps;
+        (*it)->node->sequence->num_gaps += simulateGillespieEvents(segment_start, model, node_seq_chunk, sequence_length, num_gaps, branch_length, simulation_method, site_locked_vec, total_predefined_mutation_count, true, latest_insertion, rstream, generator);
+    }
+    if (latest_insertion != insertion_before_simulation)
+        segment_length = sequence_length;
+    
+    // if insertion events occur -> insert gaps to other nodes
+    if (insertion_before_simulation && insertion_before_simulation->next)
+    {
+        // init a genome_tree to update new genomes for internal nodes
+        GenomeTree* genome_tree = new GenomeTree();
+        genome_tree->buildGenomeTree(insertion_before_simulation, ori_seq_length);
+        
+        // update non-empty internal sequences due to insertions
+        updateInternalSeqsIndels(genome_tree, sequence_length, (*it)->node);
+        
+        // delete genome_tree
+        delete genome_tree;
+        
+        // re-compute the switching param to switch between Rate matrix and Probability matrix
+        computeSwitchingParam(sequence_length);
+    }
+}
+
+/**
+    simulate the events of the Gillespie algorithm along a branch on a sequence or on a segment of it
+*/
+int AliSimulator::simulateGillespieEvents(int segment_start, ModelSubst *model, vector<short int> &node_seq_chunk, int &sequence_length, int num_gaps, double branch_length, SIMULATION_METHOD simulation_method, std::vector<bool>* const site_locked_vec, int predefined_mutation_count, bool last_segment, Insertion* &last_insertion, int *rstream, default_random_engine& generator)
+{
+    int num_deleted_sites = 0;
     double total_sub_rate = 0;
-    vector<double> sub_rate_by_site;
+    SiteRateSampler sub_rate_by_site;
     // If AliSim is using RATE_MATRIX approach -> initialize variables for Rate_matrix approach: total_sub_rate, accumulated_rates, num_gaps
     if (simulation_method == RATE_MATRIX || params->indel_rate_variation)
     {
-        initVariables4RateMatrix(segment_start, total_sub_rate, num_gaps, sub_rate_by_site, node_seq_chunk);
+        vector<double> site_rates;
+        initVariables4RateMatrix(segment_start, total_sub_rate, num_gaps, site_rates, node_seq_chunk);
+        sub_rate_by_site.init(site_rates);
         
         // handle cases when total_sub_rate == NaN due to extreme freqs
         if (total_sub_rate != total_sub_rate)
             total_sub_rate = 0;
     }
-    else // otherwise, TRANS_PROB_MATRIX approach is used -> only count the number of gaps
-        num_gaps = (*it)->node->sequence->num_gaps;
     
     double total_ins_rate = 0;
     double total_del_rate = 0;
@@ -2841,9 +2880,18 @@ void AliSimulator::simulateSeqByGillespie(int segment_start, int &segment_length
         // constant indel-rates
         if (!params->indel_rate_variation)
         {
+            // only the last segment has the positions after the last site
             int tmp_num = sequence_length - num_gaps;
-            total_ins_rate = params->alisim_insertion_ratio * (tmp_num + 1);
-            total_del_rate = params->alisim_deletion_ratio * (tmp_num - 1 + computeMeanDelSize(sequence_length));
+            if (last_segment)
+            {
+                total_ins_rate = params->alisim_insertion_ratio * (tmp_num + 1);
+                total_del_rate = params->alisim_deletion_ratio * (tmp_num - 1 + computeMeanDelSize(sequence_length));
+            }
+            else
+            {
+                total_ins_rate = params->alisim_insertion_ratio * tmp_num;
+                total_del_rate = params->alisim_deletion_ratio * tmp_num;
+            }
         }
         // indel-rate variation
         else
@@ -2859,11 +2907,6 @@ void AliSimulator::simulateSeqByGillespie(int segment_start, int &segment_length
     if (simulation_method == RATE_MATRIX)
         total_event_rate += total_sub_rate;
     
-    // dummy variables
-    int ori_seq_length = node_seq_chunk.size();
-    Insertion* insertion_before_simulation = latest_insertion;
-    
-    double branch_length = (*it)->length * params->alisim_branch_scale * partition_rate;
     while (branch_length > 0)
     {
         // generate a waiting time s1 by sampling from the exponential distribution with mean 1/total_event_rate
@@ -2893,15 +2936,14 @@ void AliSimulator::simulateSeqByGillespie(int segment_start, int &segment_length
             {
                 case INSERTION:
                 {
-                    length_change = handleInsertion(sequence_length, node_seq_chunk, total_sub_rate, sub_rate_by_site, simulation_method, generator);
-                    segment_length = sequence_length;
+                    length_change = handleInsertion(sequence_length, node_seq_chunk, total_sub_rate, sub_rate_by_site, simulation_method, generator, last_insertion, last_segment);
                     break;
                 }
                 case DELETION:
                 {
                     int deletion_length = handleDeletion(sequence_length, node_seq_chunk, total_sub_rate, sub_rate_by_site, simulation_method, generator);
                     length_change = -deletion_length;
-                    (*it)->node->sequence->num_gaps += deletion_length;
+                    num_deleted_sites += deletion_length;
                     break;
                 }
                 case SUBSTITUTION:
@@ -2947,22 +2989,88 @@ void AliSimulator::simulateSeqByGillespie(int segment_start, int &segment_length
 
     }
     
-    // if insertion events occur -> insert gaps to other nodes
-    if (insertion_before_simulation && insertion_before_simulation->next)
+    return num_deleted_sites;
+}
+
+/**
+    get the number of segments of the sequence to simulate the Gillespie events of a branch in parallel
+*/
+int AliSimulator::getNumGillespieSegments(int sequence_length, std::vector<bool>* const site_locked_vec, int predefined_mutation_count)
+{
+    // the sites of a segment must not share states with other segments:
+    // site-specific rates, models, and patterns are updated in place by insertions, predefined mutations lock sites
+    if (params->alisim_gillespie_threads <= 1 || site_locked_vec || predefined_mutation_count
+        || site_specific_rates.size() > 0 || site_specific_model_index.size() > 0 || site_to_patternID.size() > 0)
+        return 1;
+    return max(1, min(params->alisim_gillespie_threads, sequence_length / MIN_GILLESPIE_SEGMENT_LENGTH));
+}
+
+/**
+    simulate the Gillespie events of a branch on segments of the sequence in parallel
+*/
+void AliSimulator::simulateSeqByParallelGillespie(int num_segments, ModelSubst *model, vector<short int> &node_seq_chunk, int &sequence_length, NeighborVec::iterator it, SIMULATION_METHOD simulation_method, double branch_length, int *rstream, default_random_engine& generator)
+{
+    // the mean deletion-size is computed once and cached in params
+    if (params->alisim_deletion_ratio > 0 && !params->indel_rate_variation)
+        computeMeanDelSize(sequence_length);
+    
+    // draw the seeds of the segments in order, so that the simulation does not depend on the scheduling of threads
+    vector<int> segment_seeds(num_segments);
+    vector<default_random_engine::result_type> generator_seeds(num_segments);
+    for (int i = 0; i < num_segments; i++)
     {
-        // init a genome_tree to update new genomes for internal nodes
-        GenomeTree* genome_tree = new GenomeTree();
-        genome_tree->buildGenomeTree(insertion_before_simulation, ori_seq_length);
+        segment_seeds[i] = random_int(INT_MAX, rstream);
+        generator_seeds[i] = generator();
+    }
+    
+    // each segment records its insertions in its own coordinates after a dummy head
+    vector<vector<short int> > segments(num_segments);
+    vector<Insertion> segment_insertions(num_segments);
+    vector<int> num_deleted_sites(num_segments, 0);
+    int default_length = sequence_length / num_segments;
+    
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) num_threads(params->alisim_gillespie_threads)
+#endif
+    for (int i = 0; i < num_segments; i++)
+    {
+        int start = i * default_length;
+        int end = (i == num_segments - 1) ? sequence_length : (start + default_length);
+        vector<short int> &segment = segments[i];
+        segment.assign(node_seq_chunk.begin() + start, node_seq_chunk.begin() + end);
+        int segment_length = segment.size();
+        int num_gaps = count(segment.begin(), segment.end(), STATE_UNKNOWN);
         
-        // update non-empty internal sequences due to insertions
-        updateInternalSeqsIndels(genome_tree, sequence_length, (*it)->node);
+        // the indel-sizes and the inserted sequences are drawn from the default random stream
+        int *segment_rstream;
+        init_random(segment_seeds[i], false, &segment_rstream);
+        int *saved_randstream = thread_randstream;
+        thread_randstream = segment_rstream;
+        default_random_engine segment_generator(generator_seeds[i]);
         
-        // delete genome_tree
-        delete genome_tree;
+        Insertion *last_insertion = &segment_insertions[i];
+        num_deleted_sites[i] = simulateGillespieEvents(0, model, segment, segment_length, num_gaps, branch_length, simulation_method, nullptr, 0, i == num_segments - 1, last_insertion, segment_rstream, segment_generator);
         
-        // re-compute the switching param to switch between Rate matrix and Probability matrix
-        computeSwitchingParam(sequence_length);
+        thread_randstream = saved_randstream;
+        finish_random(segment_rstream);
     }
+    
+    // merge the segments, an insertion in a segment occurs after all insertions in the previous segments
+    node_seq_chunk.clear();
+    for (int i = 0; i < num_segments; i++)
+    {
+        int offset = node_seq_chunk.size();
+        for (Insertion *insertion = segment_insertions[i].next; insertion; insertion = insertion->next)
+        {
+            insertion->pos += offset;
+            latest_insertion->next = insertion;
+            latest_insertion = insertion;
+        }
+        segment_insertions[i].next = nullptr;
+        node_seq_chunk.insert(node_seq_chunk.end(), segments[i].begin(), segments[i].end());
+        (*it)->node->sequence->num_gaps += num_deleted_sites[i];
+    }
+    sequence_length = node_seq_chunk.size();
 }
 
 /**
@@ -3049,19 +3157,16 @@ void AliSimulator::updateInternalSeqsFromNodeToRoot(GenomeTree* genome_tree, int
 /**
     handle insertion events
 */
-int AliSimulator::handleInsertion(int &sequence_length, vector<short int> &indel_sequence, double &total_sub_rate, vector<double> &sub_rate_by_site, SIMULATION_METHOD simulation_method, default_random_engine& generator)
+int AliSimulator::handleInsertion(int &sequence_length, vector<short int> &indel_sequence, double &total_sub_rate, SiteRateSampler &sub_rate_by_site, SIMULATION_METHOD simulation_method, default_random_engine& generator, Insertion* &last_insertion, bool allow_append)
 {
     // Randomly select the position/site (from the set of all sites) where the insertion event occurs
     int position;
     // with constant indel-rate -> based on a uniform distribution between 0 and the current length of the sequence
     if (!params->indel_rate_variation)
-        position = selectValidPositionForIndels(sequence_length + 1, indel_sequence);
+        position = selectValidPositionForIndels(allow_append ? sequence_length + 1 : sequence_length, indel_sequence);
     // with indel-rate variation -> based on the sub_rate_by_site
     else
-    {
-        discrete_distribution<> random_discrete_dis(sub_rate_by_site.begin(), sub_rate_by_site.end());
-        position = random_discrete_dis(generator);
-    }
+        position = sub_rate_by_site.sampleSite(generator);
     
     // Randomly generate the length (length_I) of inserted sites from the indel-length distribution (​​geometric distribution (by default) or user-defined distributions).
     int length = -1;
@@ -3087,15 +3192,16 @@ int AliSimulator::handleInsertion(int &sequence_length, vector<short int> &indel
     {
         // update sub_rate_by_site of the inserted sites
         double sub_rate_change = 0;
-        sub_rate_by_site.insert(sub_rate_by_site.begin()+position, length, 0);
+        vector<double> new_rates(length, 0);
         for (int i = position; i < position + length; i++)
         {
             // NHANLT: potential improvement
             // cache site_specific_model_index[i] * max_num_states
             double sub_rate_from_model = site_specific_model_index.size() == 0 ? sub_rates[indel_sequence[i]] : sub_rates[site_specific_model_index[i] * max_num_states + indel_sequence[i]];
-            sub_rate_by_site[i] = site_specific_rates.size() > 0 ? (site_specific_rates[i] * sub_rate_from_model) : sub_rate_from_model;
-            sub_rate_change += sub_rate_by_site[i];
+            new_rates[i - position] = site_specific_rates.size() > 0 ? (site_specific_rates[i] * sub_rate_from_model) : sub_rate_from_model;
+            sub_rate_change += new_rates[i - position];
         }
+        sub_rate_by_site.insertSites(position, new_rates);
         
         // update total_sub_rate
         total_sub_rate += sub_rate_change;
@@ -3103,8 +3209,8 @@ int AliSimulator::handleInsertion(int &sequence_length, vector<short int> &indel
     
     // record the insertion event
     Insertion* new_insertion = new Insertion(position, length, position == sequence_length);
-    latest_insertion->next = new_insertion;
-    latest_insertion = new_insertion;
+    last_insertion->next = new_insertion;
+    last_insertion = new_insertion;
     
     // update the sequence_length
     sequence_length += length;
@@ -3116,7 +3222,7 @@ int AliSimulator::handleInsertion(int &sequence_length, vector<short int> &indel
 /**
     handle deletion events
 */
-int AliSimulator::handleDeletion(int sequence_length, vector<short int> &indel_sequence, double &total_sub_rate, vector<double> &sub_rate_by_site, SIMULATION_METHOD simulation_method, default_random_engine& generator)
+int AliSimulator::handleDeletion(int sequence_length, vector<short int> &indel_sequence, double &total_sub_rate, SiteRateSampler &sub_rate_by_site, SIMULATION_METHOD simulation_method, default_random_engine& generator)
 {
     // Randomly generate the length (length_D) of sites (which will be deleted) from the indel-length distribution.
     int length = -1;
@@ -3143,10 +3249,7 @@ int AliSimulator::handleDeletion(int sequence_length, vector<short int> &indel_s
     }
     // with indel-rate variation -> based on the sub_rate_by_site
     else
-    {
-        discrete_distribution<> random_discrete_dis(sub_rate_by_site.begin(), sub_rate_by_site.end());
-        position = random_discrete_dis(generator);
-    }
+        position = sub_rate_by_site.sampleSite(generator);
     
     // Replace up to length_D sites by gaps from the sequence starting at the selected location
     int real_deleted_length = 0;
@@ -3169,8 +3272,8 @@ int AliSimulator::handleDeletion(int sequence_length, vector<short int> &indel_s
         // if RATE_MATRIX approach is used -> update sub_rate_by_site
         if (simulation_method == RATE_MATRIX || params->indel_rate_variation)
         {
-            sub_rate_change -= sub_rate_by_site[position + i];
-            sub_rate_by_site[position + i] = 0;
+            sub_rate_change -= sub_rate_by_site.getRate(position + i);
+            sub_rate_by_site.setRate(position + i, 0);
         }
     }
     
@@ -3185,15 +3288,14 @@ int AliSimulator::handleDeletion(int sequence_length, vector<short int> &indel_s
 /**
     handle substitution events
 */
-void AliSimulator::handleSubs(int segment_start, double &total_sub_rate, vector<double> &sub_rate_by_site, vector<short int> &indel_sequence, int num_mixture_models, std::vector<bool>* const site_locked_vec, int* rstream, default_random_engine& generator)
+void AliSimulator::handleSubs(int segment_start, double &total_sub_rate, SiteRateSampler &sub_rate_by_site, vector<short int> &indel_sequence, int num_mixture_models, std::vector<bool>* const site_locked_vec, int* rstream, default_random_engine& generator)
 {
     // select a position where the substitution event occurs
-    discrete_distribution<> random_discrete_dis(sub_rate_by_site.begin(), sub_rate_by_site.end());
     int pos;
     // make up to indel_sequence.size() attempts to select an unlocked site
     for (int i = 0; i < indel_sequence.size(); i++)
     {
-        pos = random_discrete_dis(generator);
+        pos = sub_rate_by_site.sampleSite(generator);
 
         // a valid site must NOT be locked
         if (!site_locked_vec || !site_locked_vec->at(segment_start + pos))
@@ -3227,7 +3329,7 @@ void AliSimulator::handleSubs(int segment_start, double &total_sub_rate, vector<
     total_sub_rate += sub_rate_change;
     
     // update sub_rate_by_site
-    sub_rate_by_site[pos] += sub_rate_change;
+    sub_rate_by_site.addRate(pos, sub_rate_change);
 }
 
 /**
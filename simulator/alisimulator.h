@@ -30,6 +30,7 @@
 #endif
 #include "utils/MPIHelper.h"
 #include "alignment/sequencechunkstr.h"
+#include "siteratesampler.h"
 
 struct FunDi_Item {
   int selected_site;
@@ -45,6 +46,11 @@ enum EVENT_TYPE {
     SUBSTITUTION
 };
 
+/**
+ *  minimum number of sites per segment to simulate the Gillespie events of a branch in parallel
+ */
+const int MIN_GILLESPIE_SEGMENT_LENGTH = 10000;
+
 class AliSimulator{
 protected:
     
@@ -248,20 +254,45 @@ protected:
     */
     void simulateSeqByGillespie(int segment_start, int &segment_length, ModelSubst *model, vector<short int> &node_seq_chunk, int &sequence_length, NeighborVec::iterator it, SIMULATION_METHOD simulation_method, std::vector<bool>* const site_locked_vec, const int& total_predefined_mutation_count, int *rstream, default_random_engine& generator);
     
+    /**
+        simulate the events of the Gillespie algorithm along a branch on a sequence or on a segment of it
+        @param num_gaps number of gaps in the sequence, recounted if the rates of sites are needed
+        @param last_segment FALSE if other segments follow, so that insertions after the last site are not allowed
+        @param last_insertion the last recorded insertion, updated with the new insertions
+        @return number of deleted sites
+    */
+    int simulateGillespieEvents(int segment_start, ModelSubst *model, vector<short int> &node_seq_chunk, int &sequence_length, int num_gaps, double branch_length, SIMULATION_METHOD simulation_method, std::vector<bool>* const site_locked_vec, int predefined_mutation_count, bool last_segment, Insertion* &last_insertion, int *rstream, default_random_engine& generator);
+    
+    /**
+        get the number of segments of the sequence to simulate the Gillespie events of a branch in parallel,
+        1 if the sites of a segment share states with other segments
+    */
+    int getNumGillespieSegments(int sequence_length, std::vector<bool>* const site_locked_vec, int predefined_mutation_count);
+    
+    /**
+        simulate the Gillespie events of a branch on segments of the sequence in parallel.
+        Each segment evolves independently with the per-site event rates of the whole sequence,
+        a deletion is truncated at the end of its segment. The insertions are merged into the list of insertions
+        in the coordinates of the whole sequence
+    */
+    void simulateSeqByParallelGillespie(int num_segments, ModelSubst *model, vector<short int> &node_seq_chunk, int &sequence_length, NeighborVec::iterator it, SIMULATION_METHOD simulation_method, double branch_length, int *rstream, default_random_engine& generator);
+    
     /**
         handle substitution events
     */
-    void handleSubs(int segment_start, double &total_sub_rate, vector<double> &sub_rate_by_site, vector<short int> &indel_sequence, int num_mixture_models, std::vector<bool>* const site_locked_vec, int* rstream, default_random_engine& generator);
+    void handleSubs(int segment_start, double &total_sub_rate, SiteRateSampler &sub_rate_by_site, vector<short int> &indel_sequence, int num_mixture_models, std::vector<bool>* const site_locked_vec, int* rstream, default_random_engine& generator);
     
     /**
         handle insertion events, return the insertion-size
+        @param last_insertion the last recorded insertion, updated with the new insertion
+        @param allow_append FALSE to not insert after the last site, if other segments of the sequence follow
     */
-    int handleInsertion(int &sequence_length, vector<short int> &indel_sequence, double &total_sub_rate, vector<double> &sub_rate_by_site, SIMULATION_METHOD simulation_method, default_random_engine& generator);
+    int handleInsertion(int &sequence_length, vector<short int> &indel_sequence, double &total_sub_rate, SiteRateSampler &sub_rate_by_site, SIMULATION_METHOD simulation_method, default_random_engine& generator, Insertion* &last_insertion, bool allow_append = true);
     
     /**
         handle deletion events, return the deletion-size
     */
-    int handleDeletion(int sequence_length, vector<short int> &indel_sequence, double &total_sub_rate, vector<double> &sub_rate_by_site, SIMULATION_METHOD simulation_method, default_random_engine& generator);
+    int handleDeletion(int sequence_length, vector<short int> &indel_sequence, double &total_sub_rate, SiteRateSampler &sub_rate_by_site, SIMULATION_METHOD simulation_method, default_random_engine& generator);
     
     /**
         extract array of substitution rates and Jmatrix
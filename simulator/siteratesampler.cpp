@@ -0,0 +1,87 @@
+//
+//  siteratesampler.cpp
+//  iqtree
+//
+//  Dynamic sampler of sites proportional to their substitution rates for the Gillespie algorithm
+//
+
+#include "siteratesampler.h"
+
+void SiteRateSampler::init(vector<double> &site_rates)
+{
+    rates.swap(site_rates);
+    site_rates.clear();
+    build();
+}
+
+void SiteRateSampler::build()
+{
+    int num_sites = rates.size();
+    sums.resize(num_sites + 1);
+    sums[0] = 0;
+    for (int i = 1; i <= num_sites; i++)
+        sums[i] = rates[i - 1];
+    // add each node into its parent, O(L) in total
+    for (int i = 1; i <= num_sites; i++)
+    {
+        int parent = i + (i & -i);
+        if (parent <= num_sites)
+            sums[parent] += sums[i];
+    }
+    
+    top_step = 1;
+    while (top_step * 2 <= num_sites)
+        top_step *= 2;
+}
+
+void SiteRateSampler::addRate(int site, double rate_change)
+{
+    rates[site] += rate_change;
+    int num_sites = rates.size();
+    for (int i = site + 1; i <= num_sites; i += (i & -i))
+        sums[i] += rate_change;
+}
+
+void SiteRateSampler::insertSites(int position, vector<double> &new_rates)
+{
+    rates.insert(rates.begin() + position, new_rates.begin(), new_rates.end());
+    build();
+}
+
+double SiteRateSampler::getTotalRate() const
+{
+    double total = 0;
+    for (int i = rates.size(); i > 0; i -= (i & -i))
+        total += sums[i];
+    return total;
+}
+
+int SiteRateSampler::sampleSite(default_random_engine &generator) const
+{
+    int num_sites = rates.size();
+    if (num_sites == 0)
+        return 0;
+    
+    uniform_real_distribution<double> random_uniform_dis(0.0, getTotalRate());
+    double remaining = random_uniform_dis(generator);
+    
+    // descend the tree to the first site whose accumulated rate exceeds the random number
+    int pos = 0;
+    for (int step = top_step; step > 0; step >>= 1)
+    {
+        int next = pos + step;
+        if (next <= num_sites && sums[next] <= remaining)
+        {
+            pos = next;
+            remaining -= sums[next];
+        }
+    }
+    
+    // rounding errors may point to a site with zero rate (e.g., a deleted site) -> take the closest preceding site with a positive rate
+    if (pos >= num_sites)
+        pos = num_sites - 1;
+    for (int i = pos; i >= 0; i--)
+        if (rates[i] > 0)
+            return i;
+    return pos;
+}
@@ -0,0 +1,91 @@
+//
+//  siteratesampler.h
+//  iqtree
+//
+//  Dynamic sampler of sites proportional to their substitution rates for the Gillespie algorithm
+//
+
+#ifndef siteratesampler_h
+#define siteratesampler_h
+
+#include <vector>
+#include <random>
+
+using namespace std;
+
+/**
+    sampler of sites with probability proportional to their rates, where the rates change over time.
+    The rates are summed up in a Fenwick tree so that sampling a site and updating its rate take O(log L)
+    instead of rebuilding a discrete_distribution over all L sites for every event
+*/
+class SiteRateSampler
+{
+public:
+    
+    /**
+        build the sampler in O(L)
+        @param site_rates rates of the sites, moved into the sampler
+    */
+    void init(vector<double> &site_rates);
+    
+    /**
+        @return number of sites
+    */
+    int size() const { return rates.size(); }
+    
+    /**
+        @return rate of a site
+    */
+    double getRate(int site) const { return rates[site]; }
+    
+    /**
+        set the rate of a site in O(log L)
+    */
+    void setRate(int site, double rate) { addRate(site, rate - rates[site]); }
+    
+    /**
+        add a change to the rate of a site in O(log L)
+    */
+    void addRate(int site, double rate_change);
+    
+    /**
+        insert sites before a position, rebuilding the sampler in O(L)
+        @param position position of the first inserted site
+        @param new_rates rates of the inserted sites
+    */
+    void insertSites(int position, vector<double> &new_rates);
+    
+    /**
+        @return sum of the rates of all sites in O(log L)
+    */
+    double getTotalRate() const;
+    
+    /**
+        randomly select a site with probability proportional to its rate in O(log L)
+    */
+    int sampleSite(default_random_engine &generator) const;
+    
+protected:
+    
+    /**
+        build the Fenwick tree from the rates
+    */
+    void build();
+    
+    /**
+        rate of each site
+    */
+    vector<double> rates;
+    
+    /**
+        Fenwick tree, 1-based: sums[i] is the sum of the rates of sites [i - (i & -i), i)
+    */
+    vector<double> sums;
+    
+    /**
+        highest power of two not greater than the number of sites
+    */
+    int top_step = 0;
+};
+
+#endif /* siteratesampler_h */
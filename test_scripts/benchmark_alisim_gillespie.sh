@@ -0,0 +1,33 @@
+#!/bin/bash
+# Micro-benchmark of the Gillespie (rate matrix) simulation of AliSim:
+# substitution events per second on long sequences.
+#
+# Args: $1 = IQ-TREE binary (default: build/iqtree3)
+#       $2 = sequence length (default: 1000000)
+#       $3 = branch length (default: 0.01), with 4 taxa the tree has 5 branches
+#       $4 = extra AliSim options (default: none), e.g. "--indel 0.1,0.1 --indel-rate-variation"
+
+iqtree="${1:-build/iqtree3}"
+length="${2:-1000000}"
+brlen="${3:-0.01}"
+options="${4:-}"
+
+dir=$(mktemp -d)
+echo "(A:$brlen,B:$brlen,(C:$brlen,D:$brlen):$brlen);" > "$dir/tree.nwk"
+
+# --simulation-thresh 1 forces the rate matrix approach on all branches
+start=$(date +%s.%N)
+"$iqtree" --alisim "$dir/aln" -t "$dir/tree.nwk" -m JC --length "$length" --simulation-thresh 1 -seed 1 $options > "$dir/log" 2>&1
+status=$?
+end=$(date +%s.%N)
+if [ $status -ne 0 ]; then
+    echo "ERROR: AliSim run failed, see $dir/log"
+    exit 1
+fi
+
+# the expected number of substitutions is the tree length times the sequence length
+awk -v len="$length" -v bl="$brlen" -v t0="$start" -v t1="$end" 'BEGIN {
+    events = 5 * bl * len; secs = t1 - t0;
+    printf("%d sites, %d substitution events in %.2f sec: %.0f events/sec\n", len, events, secs, events/secs);
+}'
+rm -rf "$dir"
@@ -0,0 +1,53 @@
+#!/bin/bash
+# Benchmark of the HMM tree mixture (-hmmster), comparing the forward/backward
+# recursions in log space (default) with the scaled linear space (-hmm_linear).
+# The alignment concatenates segments simulated along different random trees.
+#
+# Args: $1 = IQ-TREE binary (default: build/iqtree3)
+#       $2 = number of trees, i.e. HMM categories (default: 4)
+#       $3 = number of sites per tree (default: 20000)
+#       $4 = extra IQ-TREE options (default: none), e.g. "-T 4"
+
+iqtree="${1:-build/iqtree3}"
+ntree="${2:-4}"
+length="${3:-20000}"
+options="${4:-}"
+
+dir=$(mktemp -d)
+for i in $(seq 1 "$ntree"); do
+    "$iqtree" -r 12 "$dir/t$i.nwk" -seed "$i" -redo > "$dir/sim.log" 2>&1 &&
+    "$iqtree" --alisim "$dir/s$i" -t "$dir/t$i.nwk" -m GTR+G --length "$length" -seed "$i" -af fasta > "$dir/sim.log" 2>&1
+    if [ $? -ne 0 ]; then
+        echo "ERROR: simulation failed, see $dir/sim.log"
+        exit 1
+    fi
+    cat "$dir/t$i.nwk" >> "$dir/trees.nwk"
+done
+# concatenate the segments of each taxon
+awk '/^>/ {name = $0; if (!(name in seq)) order[++n] = name; next} {seq[name] = seq[name] $0}
+     END {for (i = 1; i <= n; i++) print order[i] "\n" seq[order[i]]}' "$dir"/s*.fa > "$dir/aln.fa"
+
+for mode in log linear; do
+    flag=""
+    if [ "$mode" = "linear" ]; then
+        flag="-hmm_linear"
+    fi
+    start=$(date +%s.%N)
+    "$iqtree" -s "$dir/aln.fa" -m "GTR+G+T" -te "$dir/trees.nwk" -hmmster $flag -seed 1 -pre "$dir/$mode" $options > "$dir/$mode.log" 2>&1
+    status=$?
+    end=$(date +%s.%N)
+    if [ $status -ne 0 ]; then
+        echo "ERROR: IQ-TREE run failed, see $dir/$mode.log"
+        exit 1
+    fi
+    logl=$(grep "HMM log-likelihood" "$dir/$mode.log" | tail -n 1 | awk '{print $NF}')
+    awk -v m="$mode" -v n="$ntree" -v l="$logl" -v t0="$start" -v t1="$end" 'BEGIN {
+        printf("%-6s space, %d trees: HMM LogL %s in %.2f sec\n", m, n, l, t1 - t0);
+    }'
+done
+# the site assignments must agree, the path log-likelihood only up to rounding
+if ! diff -q <(grep -v "log likelihood" "$dir/log.hmm") <(grep -v "log likelihood" "$dir/linear.hmm") > /dev/null; then
+    echo "NOTE: the site assignments differ between log and linear space, see $dir"
+    exit 0
+fi
+rm -rf "$dir"
@@ -0,0 +1,54 @@
+#!/bin/bash
+# Micro-benchmark of the likelihood kernels for every (instruction set, number of states) pair.
+# Each alignment is simulated along a random tree, then the model parameters and branch
+# lengths are optimized on that fixed tree, which is dominated by kernel calls.
+# The throughput is reported as patterns x seconds^-1 of the whole run.
+#
+# Args: $1 = IQ-TREE binary (default: build/iqtree3)
+#       $2 = number of taxa (default: 30)
+#       $3 = number of sites, codons for codon data (default: 3000)
+#       $4 = instruction sets (default: "SSE AVX FMA AVX512")
+
+iqtree="${1:-build/iqtree3}"
+ntaxa="${2:-30}"
+length="${3:-3000}"
+isas="${4:-SSE AVX FMA AVX512}"
+
+dir=$(mktemp -d)
+"$iqtree" -r "$ntaxa" "$dir/tree.nwk" -seed 1 -redo > "$dir/sim.log" 2>&1
+# name, sequence type, model: 2, 4, 20 and 61 states
+datasets="bin:BIN:GTR2+FO+G dna:DNA:GTR+G aa:AA:LG+G codon:CODON:GY+G"
+for data in $datasets; do
+    IFS=: read -r name seqtype model <<< "$data"
+    # AliSim takes the codon alignment length in nucleotides
+    nsite="$length"
+    if [ "$seqtype" = "CODON" ]; then
+        nsite=$((length * 3))
+    fi
+    "$iqtree" --alisim "$dir/$name" -t "$dir/tree.nwk" -st "$seqtype" -m "$model" --length "$nsite" -seed 1 -af phy >> "$dir/sim.log" 2>&1
+    if [ $? -ne 0 ]; then
+        echo "ERROR: simulation of $name data failed, see $dir/sim.log"
+        exit 1
+    fi
+done
+
+printf "%-7s %-6s %8s %10s %14s %s\n" "ISA" "data" "patterns" "time(s)" "patterns/sec" "LogL"
+for isa in $isas; do
+    for data in $datasets; do
+        IFS=: read -r name seqtype model <<< "$data"
+        start=$(date +%s.%N)
+        "$iqtree" -s "$dir/$name.phy" -st "$seqtype" -te "$dir/tree.nwk" -m "$model" -lk "$isa" -seed 1 -pre "$dir/$name.$isa" > "$dir/$name.$isa.out" 2>&1
+        status=$?
+        end=$(date +%s.%N)
+        if [ $status -ne 0 ]; then
+            echo "ERROR: IQ-TREE run failed, see $dir/$name.$isa.out"
+            exit 1
+        fi
+        npattern=$(grep -o "[0-9]* distinct patterns" "$dir/$name.$isa.log" | head -1 | cut -d' ' -f1)
+        logl=$(grep "^Log-likelihood of the tree" "$dir/$name.$isa.iqtree" | awk '{print $5}')
+        awk -v isa="$isa" -v n="$name" -v p="$npattern" -v l="$logl" -v t0="$start" -v t1="$end" 'BEGIN {
+            printf("%-7s %-6s %8d %10.2f %14.0f %s\n", isa, n, p, t1 - t0, p / (t1 - t0), l);
+        }'
+    done
+done
+rm -rf "$dir"
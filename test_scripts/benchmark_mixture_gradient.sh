@@ -0,0 +1,37 @@
+#!/bin/bash
+# Benchmark of BFGS optimization of the tree weights of a tree mixture model (+T)
+# with many trees, where each BFGS iteration needs the gradient on all tree weights.
+#
+# Args: $1 = IQ-TREE binary (default: build/iqtree3)
+#       $2 = alignment (default: example/example.phy)
+#       $3 = number of trees in the mixture (default: 20)
+#       $4 = extra IQ-TREE options (default: none), e.g. "-T 4"
+
+iqtree="${1:-build/iqtree3}"
+aln="${2:-example/example.phy}"
+ntree="${3:-20}"
+options="${4:-}"
+
+dir=$(mktemp -d)
+# distinct UFBoot trees serve as the trees of the mixture
+"$iqtree" -s "$aln" -m GTR+G -B 1000 --boot-trees -seed 1 -pre "$dir/boot" > "$dir/boot.log" 2>&1
+sort -u "$dir/boot.ufboot" | head -n "$ntree" > "$dir/trees.nwk"
+if [ $(wc -l < "$dir/trees.nwk") -lt "$ntree" ]; then
+    echo "ERROR: fewer than $ntree distinct UFBoot trees, see $dir/boot.log"
+    exit 1
+fi
+
+start=$(date +%s.%N)
+"$iqtree" -s "$aln" -m "GTR+G+T" -te "$dir/trees.nwk" -optalg_treeweight BFGS -seed 1 -pre "$dir/run" $options > "$dir/log" 2>&1
+status=$?
+end=$(date +%s.%N)
+if [ $status -ne 0 ]; then
+    echo "ERROR: IQ-TREE run failed, see $dir/log"
+    exit 1
+fi
+
+logl=$(grep "^Log-likelihood of the tree" "$dir/run.iqtree" | awk '{print $5}')
+awk -v n="$ntree" -v l="$logl" -v t0="$start" -v t1="$end" 'BEGIN {
+    printf("%d-tree mixture: LogL %s in %.2f sec\n", n, l, t1 - t0);
+}'
+rm -rf "$dir"
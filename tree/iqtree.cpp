@@ -61,6 +61,8 @@ void IQTree::init() {
 //    write_intermediate_trees = 0;
 //    max_candidate_trees = 0;
     logl_cutoff = 0.0;
+    num_rell_trees = 0;
+    rell_time = 0.0;
     len_scale = 10000;
 //    save_all_br_lens = false;
     duplication_counter = 0;
@@ -85,6 +87,7 @@ void IQTree::init() {
     on_refine_btree = false;
     contree_rfdist = -1;
     boot_consense_logl = 0.0;
+    nni_workers_lh_bytes = 0;
 
 }
 
@@ -377,10 +380,37 @@ void IQTree::initSettings(Params &params) {
 #else
         size_t nptn = get_safe_upper_limit(orig_nptn);
 #endif
-        BootValType *mem = aligned_alloc<BootValType>(nptn * (size_t)(params.gbo_replicates));
-        memset(mem, 0, nptn * (size_t)(params.gbo_replicates) * sizeof(BootValType));
-        for (i = 0; i < params.gbo_replicates; i++) {
-            boot_samples[i] = mem + i*nptn;
+        uint64_t dense_mem = nptn * (uint64_t)params.gbo_replicates * sizeof(BootValType);
+        if (!params.ufboot_compact) {
+            // leave most of the memory to the partial likelihoods
+            double mem_budget = getMemorySize();
+            if (params.max_mem_size > 1.0)
+                mem_budget = min(mem_budget, params.max_mem_size);
+            else if (params.max_mem_size > 0.0)
+                mem_budget *= params.max_mem_size;
+            if (dense_mem > mem_budget / 4) {
+                params.ufboot_compact = true;
+                cout << "NOTE: UFBoot samples stored as 8-bit counts to save "
+                     << (dense_mem - nptn * (uint64_t)params.gbo_replicates) / 1048576 << " MB RAM" << endl;
+            }
+        }
+        if (params.ufboot_compact) {
+            // rows are padded with zeros like pattern_lh, dotProductCountBatch reads 16 counts at once
+            size_t count_size = nptn * (size_t)(params.gbo_replicates) + 16;
+            uint8_t *mem = aligned_alloc<uint8_t>(count_size);
+            memset(mem, 0, count_size);
+            boot_sample_counts.resize(params.gbo_replicates);
+            boot_sample_extra.resize(params.gbo_replicates);
+            for (i = 0; i < params.gbo_replicates; i++) {
+                boot_sample_counts[i] = mem + i*nptn;
+                boot_samples[i] = nullptr;
+            }
+        } else {
+            BootValType *mem = aligned_alloc<BootValType>(nptn * (size_t)(params.gbo_replicates));
+            memset(mem, 0, dense_mem);
+            for (i = 0; i < params.gbo_replicates; i++) {
+                boot_samples[i] = mem + i*nptn;
+            }
         }
 
         if (boot_trees.empty()) {
@@ -403,17 +433,13 @@ void IQTree::initSettings(Params &params) {
                 }
                 IntVector this_sample;
                 bootstrap_alignment->createBootstrapAlignment(aln, &this_sample, params.bootstrap_spec);
-                for (size_t j = 0; j < orig_nptn; j++) {
-                    boot_samples[i][j] = this_sample[j];
-                }
+                setBootSample(i, this_sample);
                 bootstrap_alignment->printAlignment(params.aln_output_format, bootaln_name.c_str(), true);
                 delete bootstrap_alignment;
             } else {
                 IntVector this_sample;
                 aln->createBootstrapAlignment(this_sample, params.bootstrap_spec);
-                for (size_t j = 0; j < orig_nptn; j++) {
-                    boot_samples[i][j] = this_sample[j];
-                }
+                setBootSample(i, this_sample);
             }
         }
         verbose_mode = saved_mode;
@@ -435,7 +461,7 @@ void IQTree::initSettings(Params &params) {
             for (size_t i = 0; i < params.gbo_replicates; i++) {
                 boot_samples_int[i].resize(nptn, 0);
                 for (size_t j = 0; j < orig_nptn; j++) {
-                    boot_samples_int[i][j] = boot_samples[i][j];
+                    boot_samples_int[i][j] = getBootSampleCount(i, j);
                 }
             }
         }
@@ -458,6 +484,8 @@ IQTree::~IQTree() {
     //delete bonus_values;
     //bonus_values = nullptr;
 
+    deleteNNIWorkers();
+
     for (vector<SplitGraph*>::reverse_iterator it2 = boot_splits.rbegin(); it2 != boot_splits.rend(); it2++) {
         delete (*it2);
     }
@@ -465,9 +493,15 @@ IQTree::~IQTree() {
     //if (boot_splits) delete boot_splits;
 
     if (!boot_samples.empty()) {
-        aligned_free(boot_samples[0]); // free memory
+        if (boot_samples[0])
+            aligned_free(boot_samples[0]); // free memory
         boot_samples.clear();
     }
+    if (!boot_sample_counts.empty()) {
+        aligned_free(boot_sample_counts[0]);
+        boot_sample_counts.clear();
+        boot_sample_extra.clear();
+    }
 }
 
 extern const char *aa_model_names_rax[];
@@ -677,7 +711,8 @@ void IQTree::computeInitialTree(LikelihoodKernel kernel, istream* in) {
                 cout << "Creating fast initial parsimony tree by random order stepwise addition..." << endl;
     //            aln->orderPatternByNumChars();
                 start = getRealTime();
-                score = computeParsimonyTree(params->out_prefix, aln, randstream);
+                // nullptr: use the stream of the current bootstrap replicate if any (thread_randstream)
+                score = computeParsimonyTree(params->out_prefix, aln, nullptr);
                 cout << getRealTime() - start << " seconds, parsimony score: " << score
                     << " (based on " << aln->num_parsimony_sites << " sites)"<< endl;
                 // already fixed branch length
@@ -861,7 +896,7 @@ void IQTree::initCandidateTreeSet(int nParTrees, int nNNITrees) {
 #ifdef _OPENMP
             PhyloTree::readTreeString(pars_trees[treeNr-1]);
 #else
-            computeParsimonyTree(nullptr, aln, randstream);
+            computeParsimonyTree(nullptr, aln, nullptr);
 #endif
         } else {
             //Use the tree we've already got!
@@ -1002,7 +1037,7 @@ void IQTree::initCandidateTreeSet(int nParTrees, int nNNITrees) {
         wrapperFixNegativeBranch(true);
         parsimonyTreeString = getTreeString();
     } else {
-        computeParsimonyTree(nullptr, aln, randstream);
+        computeParsimonyTree(nullptr, aln, nullptr);
         parsimonyTreeString = getTreeString();
     }
     return parsimonyTreeString;
@@ -2705,6 +2740,11 @@ double IQTree::doTreeSearch() {
     MPIHelper::getInstance().resetNumbers();
 #endif
 
+    if (verbose_mode >= VB_MED && lh_cache.num_hits + lh_cache.num_misses > 0) {
+        cout << "Subtree likelihood cache: " << lh_cache.num_hits << " hits, "
+             << lh_cache.num_misses << " misses" << endl;
+    }
+
     cout << "TREE SEARCH COMPLETED AFTER " << stop_rule.getCurIt() << " ITERATIONS"
     << " / Time: " << convert_time(getRealTime() - params->start_real_time) << endl << endl;
 
@@ -3564,7 +3604,7 @@ void IQTree::pllInitUFBootData(){
                 }
                 for(int j = 0; j < pllAlignment->sequenceLength; j++){
                     pllUFBootDataPtr->boot_samples[i][j] =
-                        boot_samples[i][pll2iqtree_pattern_index[j]];
+                        getBootSampleCount(i, pll2iqtree_pattern_index[j]);
                 }
             }
 
@@ -3723,6 +3763,16 @@ int IQTree::getDelete() const {
 }*/
 
 void IQTree::evaluateNNIs(Branches &nniBranches, vector<NNIMove>  &positiveNNIs) {
+    int num_workers = getNumNNIWorkers(nniBranches.size());
+    if (num_workers > 0) {
+        evaluateNNIsByBranch(nniBranches, positiveNNIs, num_workers);
+        // synchronize tree during optimization step
+        if (MPIHelper::getInstance().isMaster() && candidateset_changed.size() > 0
+            && MPIHelper::getInstance().gotMessage()) {
+            syncCurrentTree();
+        }
+        return;
+    }
     for (Branches::iterator it = nniBranches.begin(); it != nniBranches.end(); it++) {
         NNIMove nni = getBestNNIForBran((PhyloNode*) it->second.first, (PhyloNode*) it->second.second, nullptr);
         if (nni.newloglh > curScore) {
@@ -3737,6 +3787,208 @@ void IQTree::evaluateNNIs(Branches &nniBranches, vector<NNIMove>  &positiveNNIs)
     }
 }
 
+/**
+    cost model to choose between pattern-level and branch-level NNI evaluation,
+    measured in partial likelihood vectors computed by a single thread
+ */
+// cost of evaluating both NNIs around one branch (incl. branch length optimization)
+const double NNI_EVAL_COST = 15.0;
+// patterns a thread needs per kernel call to amortize the OpenMP synchronization
+const double NNI_SYNC_PATTERNS = 64.0;
+
+int IQTree::getNumNNIWorkers(size_t num_branches) {
+#ifdef _OPENMP
+    if (params->nni_thread_mode == NNI_THREAD_SITE)
+        return 0;
+    int max_threads = max(params->num_threads, num_threads);
+    if (max_threads <= 1 || num_branches < 2)
+        return 0;
+    // the tree copies only support plain single trees with a reversible model
+    if (isSuperTree() || isMixlen() || isTreeMix() || !constraintTree.empty())
+        return 0;
+    // UFBoot has to save every NNI tree into the master
+    if (save_all_trees == 2)
+        return 0;
+    if (params->lh_mem_save == LM_MEM_SAVE || !model->useRevKernel() || model->isSiteSpecificModel())
+        return 0;
+
+    int num_workers = min((size_t)max_threads, num_branches);
+
+    if (params->nni_thread_mode == NNI_THREAD_AUTO) {
+        // pattern-level: every kernel call is split among num_threads threads
+        double nptn = getAlnNPattern();
+        double site_speedup = num_threads * nptn / (nptn + NNI_SYNC_PATTERNS * num_threads);
+        double site_cost = NNI_EVAL_COST * num_branches / max(site_speedup, 1.0);
+        // branch-level: each tree copy first recomputes its partial likelihoods
+        double branch_cost = leafNum + NNI_EVAL_COST * ((num_branches + num_workers - 1) / num_workers);
+        if (branch_cost >= site_cost)
+            return 0;
+        // tree copies must not take more than half of the RAM
+        uint64_t mem_worker = getMemoryRequired();
+        if (mem_worker * num_workers > getMemorySize() / 2)
+            return 0;
+    }
+    return num_workers;
+#else
+    return 0;
+#endif
+}
+
+/**
+    map nodes of two trees with identical topology via the smallest taxon ID below each node
+    @param min_taxon [OUT] smallest taxon ID in the subtree below node, indexed by node ID
+    @return smallest taxon ID below node
+ */
+static int computeMinTaxonID(Node *node, Node *dad, IntVector &min_taxon) {
+    int min_id = (node->isLeaf()) ? node->id : INT_MAX;
+    FOR_NEIGHBOR_IT(node, dad, it) {
+        min_id = min(min_id, computeMinTaxonID((*it)->node, node, min_taxon));
+    }
+    min_taxon[node->id] = min_id;
+    return min_id;
+}
+
+/**
+    map nodes of src to nodes of dest (same topology) and copy branch lengths of src into dest
+    @param src_min, dest_min smallest taxon IDs below each node, see computeMinTaxonID
+    @param src2dest [OUT] nodes of dest indexed by node ID of src
+    @param dest2src [OUT] nodes of src indexed by node ID of dest
+ */
+static void mapTreeNodes(Node *src, Node *src_dad, Node *dest, Node *dest_dad,
+                         IntVector &src_min, IntVector &dest_min,
+                         vector<Node*> &src2dest, vector<Node*> &dest2src) {
+    src2dest[src->id] = dest;
+    dest2src[dest->id] = src;
+    FOR_NEIGHBOR_IT(src, src_dad, it) {
+        Node *child = (*it)->node;
+        Neighbor *dest_nei = nullptr;
+        FOR_NEIGHBOR_IT(dest, dest_dad, it2)
+            if (dest_min[(*it2)->node->id] == src_min[child->id]) {
+                dest_nei = *it2;
+                break;
+            }
+        ASSERT(dest_nei);
+        dest_nei->length = (*it)->length;
+        dest_nei->node->findNeighbor(dest)->length = (*it)->length;
+        mapTreeNodes(child, src, dest_nei->node, dest, src_min, dest_min, src2dest, dest2src);
+    }
+}
+
+/**
+    get neighbors of node (except dad) in FOR_NEIGHBOR order after swapping the subtree at nei_it
+    with the subtree at dad_nei_it of dad
+    @param neighbors [OUT] neighbor nodes are appended here
+ */
+static void getNNISwappedNeighbors(Node *node, Node *dad, NeighborVec::iterator nei_it,
+                                   NeighborVec::iterator dad_nei_it, NodeVector &neighbors) {
+    FOR_NEIGHBOR_IT(node, dad, it) {
+        neighbors.push_back((it == nei_it) ? (*dad_nei_it)->node : (*it)->node);
+    }
+}
+
+void IQTree::evaluateNNIsByBranch(Branches &nniBranches, vector<NNIMove> &positiveNNIs, int num_workers) {
+    size_t lh_bytes = getPartialLhBytes();
+    if (!nni_workers.empty() && (nni_workers.size() < num_workers || nni_workers_lh_bytes != lh_bytes
+        || nni_workers[0]->getModelFactory() != getModelFactory() || nni_workers[0]->aln != aln)) {
+        deleteNNIWorkers();
+    }
+    if (nni_workers.empty()) {
+        // keep one copy per thread for later calls with more branches
+        int pool_size = max(num_workers, max(params->num_threads, num_threads));
+        if (verbose_mode >= VB_MED) {
+            cout << "Evaluating NNIs in parallel over branches with " << pool_size << " tree copies" << endl;
+        }
+        for (int w = 0; w < pool_size; w++) {
+            PhyloTree *worker = new PhyloTree(aln);
+            worker->setParams(params);
+            worker->sse = sse;
+            worker->optimize_by_newton = optimize_by_newton;
+            worker->setNumThreads(1);
+            worker->setModelFactory(getModelFactory());
+            nni_workers.push_back(worker);
+        }
+        nni_workers_lh_bytes = lh_bytes;
+    }
+
+    vector<Branch> branches;
+    for (Branches::iterator it = nniBranches.begin(); it != nniBranches.end(); it++) {
+        branches.push_back(it->second);
+    }
+    vector<NNIMove> nniMoves(branches.size());
+    IntVector master_min(nodeNum);
+    computeMinTaxonID(root, nullptr, master_min);
+    NodeVector master_taxa;
+    getOrderedTaxa(master_taxa);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(num_workers)
+    {
+        int w = omp_get_thread_num();
+#else
+    for (int w = 0; w < num_workers; w++) {
+#endif
+        PhyloTree *worker = nni_workers[w];
+        worker->copyPhyloTree(this, true);
+        ASSERT(worker->nodeNum == nodeNum);
+        // map nodes by topology because internal node IDs may differ between the copies
+        NodeVector worker_taxa;
+        worker->getOrderedTaxa(worker_taxa);
+        IntVector worker_min(nodeNum);
+        Node *worker_root = worker_taxa[root->id];
+        computeMinTaxonID(worker_root, nullptr, worker_min);
+        vector<Node*> master2worker(nodeNum), worker2master(nodeNum);
+        mapTreeNodes(root, nullptr, worker_root, nullptr, master_min, worker_min, master2worker, worker2master);
+        worker->ptn_freq_computed = false;
+        worker->initializeAllPartialLh();
+        worker->setCurScore(curScore);
+
+        // static assignment of branches keeps the results reproducible
+        for (size_t i = w; i < branches.size(); i += num_workers) {
+            PhyloNode *node1 = (PhyloNode*)master2worker[branches[i].first->id];
+            PhyloNode *node2 = (PhyloNode*)master2worker[branches[i].second->id];
+            NNIMove nni = worker->getBestNNIForBran(node1, node2, nullptr);
+            // translate the move back into the nodes of this tree
+            NNIMove &res = nniMoves[i];
+            res = nni;
+            res.node1 = (PhyloNode*)worker2master[nni.node1->id];
+            res.node2 = (PhyloNode*)worker2master[nni.node2->id];
+            res.node1Nei_it = res.node1->findNeighborIt(worker2master[(*nni.node1Nei_it)->node->id]);
+            res.node2Nei_it = res.node2->findNeighborIt(worker2master[(*nni.node2Nei_it)->node->id]);
+            if (params->nni5) {
+                // newLen[1..4] follow the neighbor order of node1 and node2 after the swap,
+                // which differs between the tree copies
+                NodeVector worker_nei, master_nei;
+                getNNISwappedNeighbors(nni.node1, nni.node2, nni.node1Nei_it, nni.node2Nei_it, worker_nei);
+                getNNISwappedNeighbors(nni.node2, nni.node1, nni.node2Nei_it, nni.node1Nei_it, worker_nei);
+                getNNISwappedNeighbors(res.node1, res.node2, res.node1Nei_it, res.node2Nei_it, master_nei);
+                getNNISwappedNeighbors(res.node2, res.node1, res.node2Nei_it, res.node1Nei_it, master_nei);
+                for (int j = 0; j < master_nei.size(); j++)
+                    for (int k = 0; k < worker_nei.size(); k++)
+                        if (worker2master[worker_nei[k]->id] == master_nei[j] && (j < 2) == (k < 2)) {
+                            res.newLen[j+1] = nni.newLen[k+1];
+                            break;
+                        }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < branches.size(); i++) {
+        if (nniMoves[i].newloglh > curScore) {
+            positiveNNIs.push_back(nniMoves[i]);
+        }
+    }
+}
+
+void IQTree::deleteNNIWorkers() {
+    for (auto worker : nni_workers) {
+        // model is owned by this tree
+        worker->setModelFactory(nullptr);
+        delete worker;
+    }
+    nni_workers.clear();
+    nni_workers_lh_bytes = 0;
+}
+
 //Branches IQTree::getReducedListOfNNIBranches(Branches &previousNNIBranches) {
 //    Branches resBranches;
 //    for (Branches::iterator it = previousNNIBranches.begin(); it != previousNNIBranches.end(); it++) {
@@ -3849,6 +4101,59 @@ void IQTree::estimateNNICutoff(Params* params) {
     delete[] delta;
 }
 
+/** number of bootstrap samples whose RELL is computed by one call of dotProductBatch */
+const int RELL_BATCH = 16;
+
+void IQTree::setBootSample(int sample, IntVector &pattern_freq) {
+    size_t nptn = getAlnNPattern();
+    if (boot_sample_counts.empty()) {
+        for (size_t ptn = 0; ptn < nptn; ptn++) {
+            boot_samples[sample][ptn] = pattern_freq[ptn];
+        }
+        return;
+    }
+    uint8_t *counts = boot_sample_counts[sample];
+    IntVector &extra = boot_sample_extra[sample];
+    extra.clear();
+    for (size_t ptn = 0; ptn < nptn; ptn++) {
+        if (pattern_freq[ptn] < UINT8_MAX) {
+            counts[ptn] = pattern_freq[ptn];
+        } else {
+            counts[ptn] = UINT8_MAX;
+            extra.push_back(ptn);
+            extra.push_back(pattern_freq[ptn] - UINT8_MAX);
+        }
+    }
+}
+
+int IQTree::getBootSampleCount(int sample, size_t ptn) {
+    if (boot_sample_counts.empty()) {
+        return boot_samples[sample][ptn];
+    }
+    int count = boot_sample_counts[sample][ptn];
+    if (count == UINT8_MAX) {
+        IntVector &extra = boot_sample_extra[sample];
+        for (size_t i = 0; i < extra.size(); i += 2) {
+            if ((size_t)extra[i] == ptn) {
+                return count + extra[i+1];
+            }
+        }
+    }
+    return count;
+}
+
+void IQTree::computeBootCountRELL(BootValType *pattern_lh, int sample, int nvec, int nptn, BootValType *rell) {
+    size_t stride = (boot_sample_counts.size() > 1) ? boot_sample_counts[1] - boot_sample_counts[0] : 0;
+    (this->*dotProductCountBatch)(pattern_lh, boot_sample_counts[sample], stride, nvec, nptn, rell);
+    // patterns occurring more than 254 times in a sample
+    for (int vec = 0; vec < nvec; vec++) {
+        IntVector &extra = boot_sample_extra[sample + vec];
+        for (size_t i = 0; i < extra.size(); i += 2) {
+            rell[vec] += pattern_lh[extra[i]] * extra[i+1];
+        }
+    }
+}
+
 void IQTree::saveCurrentTree(double cur_logl) {
 
     if (logl_cutoff != 0.0 && cur_logl < logl_cutoff - 1.0) {
@@ -3883,18 +4188,12 @@ void IQTree::saveCurrentTree(double cur_logl) {
         // for runGuidedBootstrap
     } else {
         // online bootstrap
-//        int ptn;
-//        int updated = 0;
-//        int nsamples = boot_samples.size();
-        ostringstream ostr;
-        string tree_str;
+        double rell_start = getRealTime();
+        int nsamples = sample_end - sample_start;
+        // boot_samples are the rows of one contiguous sample x pattern matrix
+        size_t boot_stride = (boot_samples.size() > 1) ? boot_samples[1] - boot_samples[0] : 0;
+        vector<char> improved(nsamples, 0);
         setRootNode(params->root);
-        if (params->print_ufboot_trees == 2) {
-            printTree(ostr, WT_TAXON_ID + WT_SORT_TAXA + WT_BR_LEN + WT_BR_LEN_SHORT);
-        } else {
-            printTree(ostr, WT_TAXON_ID + WT_SORT_TAXA);
-        }
-        tree_str = ostr.str();
 
     #ifdef _OPENMP
         int rand_seed = random_int(1000);
@@ -3902,41 +4201,57 @@ void IQTree::saveCurrentTree(double cur_logl) {
         {
         int *rstream;
         init_random(rand_seed + omp_get_thread_num(), false, &rstream);
-        #pragma omp for
+        #pragma omp for schedule(static)
     #else
         int *rstream = randstream;
     #endif
-        for (int sample = sample_start; sample < sample_end; sample++) {
-            double rell = 0.0;
-
-            {
-                // SSE optimized version of the above loop
-                BootValType *boot_sample = boot_samples[sample];
-
-                BootValType res = (this->*dotProduct)(pattern_lh, boot_sample, nptn);
-
-                rell = res;
-            }
-
-            bool better = rell > boot_logl[sample] + params->ufboot_epsilon;
-            if (!better && rell > boot_logl[sample] - params->ufboot_epsilon) {
-                better = (random_double(rstream) <= 1.0 / (boot_counts[sample] + 1));
+        for (int block = sample_start; block < sample_end; block += RELL_BATCH) {
+            int nvec = min(RELL_BATCH, sample_end - block);
+            BootValType block_rell[RELL_BATCH];
+            if (boot_sample_counts.empty()) {
+                (this->*dotProductBatch)(pattern_lh, boot_samples[block], boot_stride, nvec, nptn, block_rell);
+            } else {
+                computeBootCountRELL(pattern_lh, block, nvec, nptn, block_rell);
             }
-            if (better) {
-                if (rell <= boot_logl[sample] + params->ufboot_epsilon) {
-                    boot_counts[sample]++;
-                } else {
-                    boot_counts[sample] = 1;
+            for (int sample = block; sample < block + nvec; sample++) {
+                double rell = block_rell[sample - block];
+                bool better = rell > boot_logl[sample] + params->ufboot_epsilon;
+                if (!better && rell > boot_logl[sample] - params->ufboot_epsilon) {
+                    better = (random_double(rstream) <= 1.0 / (boot_counts[sample] + 1));
+                }
+                if (better) {
+                    if (rell <= boot_logl[sample] + params->ufboot_epsilon) {
+                        boot_counts[sample]++;
+                    } else {
+                        boot_counts[sample] = 1;
+                    }
+                    boot_logl[sample] = max(boot_logl[sample], rell);
+                    boot_orig_logl[sample] = cur_logl;
+                    improved[sample - sample_start] = 1;
                 }
-                boot_logl[sample] = max(boot_logl[sample], rell);
-                boot_orig_logl[sample] = cur_logl;
-                boot_trees[sample] = tree_str;
             }
         }
     #ifdef _OPENMP
         finish_random(rstream);
         }
     #endif
+        // print the tree only if it is kept for some samples
+        if (find(improved.begin(), improved.end(), 1) != improved.end()) {
+            ostringstream ostr;
+            if (params->print_ufboot_trees == 2) {
+                printTree(ostr, WT_TAXON_ID + WT_SORT_TAXA + WT_BR_LEN + WT_BR_LEN_SHORT);
+            } else {
+                printTree(ostr, WT_TAXON_ID + WT_SORT_TAXA);
+            }
+            string tree_str = ostr.str();
+            for (int sample = sample_start; sample < sample_end; sample++) {
+                if (improved[sample - sample_start]) {
+                    boot_trees[sample] = tree_str;
+                }
+            }
+        }
+        num_rell_trees++;
+        rell_time += getRealTime() - rell_start;
     }
     if (Params::getInstance().print_tree_lh) {
         out_treelh << cur_logl;
@@ -4120,6 +4435,10 @@ void IQTree::writeUFBootTrees(Params &params) {
 }
 
 void IQTree::summarizeBootstrap(Params &params) {
+    if (verbose_mode >= VB_MED && num_rell_trees > 0) {
+        cout << "RELL of " << sample_end - sample_start << " bootstrap samples updated for " << num_rell_trees
+             << " trees in " << rell_time << " sec (" << rell_time * 1000.0 / num_rell_trees << " ms per tree)" << endl;
+    }
     setRootNode(params.root);
     MTreeSet trees;
     trees.init(boot_trees, rooted);
@@ -449,6 +449,30 @@ public:
      */
     void evaluateNNIs(Branches &nniBranches, vector<NNIMove> &outNNIMoves);
 
+    /**
+     * @brief Decide whether NNIs are evaluated in parallel over branches (one tree copy
+     * per thread) instead of over patterns inside the likelihood kernel
+     *
+     * @param num_branches number of branches to be evaluated
+     * @return number of tree copies to use, 0 for pattern-level parallelism
+     */
+    int getNumNNIWorkers(size_t num_branches);
+
+    /**
+     * @brief Evaluate NNIs concurrently on thread-private tree copies.
+     * Positive NNIs are returned in the same order as the serial evaluateNNIs
+     *
+     * @param nniBranches [IN] branches the branches on which NNIs will be evaluated
+     * @param num_workers number of tree copies
+     * @return list positive NNIs
+     */
+    void evaluateNNIsByBranch(Branches &nniBranches, vector<NNIMove> &outNNIMoves, int num_workers);
+
+    /**
+     * free the tree copies used by evaluateNNIsByBranch
+     */
+    void deleteNNIWorkers();
+
     // double optimizeNNIBranches(Branches &nniBranches);
 
     /**
@@ -771,9 +795,36 @@ public:
     /** log-likelihood threshold (l_min) */
     double logl_cutoff;
 
-    /** vector of bootstrap alignments generated */
+    /** vector of bootstrap alignments generated, NULL rows if ufboot_compact is set */
     vector<BootValType* > boot_samples;
 
+    /** bootstrap alignments as 8-bit pattern counts if ufboot_compact is set,
+        counts above 254 are stored as 255 with the remainder in boot_sample_extra */
+    vector<uint8_t* > boot_sample_counts;
+
+    /** for each bootstrap alignment, pairs of pattern and count exceeding 255 */
+    vector<IntVector> boot_sample_extra;
+
+    /**
+        store the pattern frequencies of a bootstrap alignment
+        @param sample bootstrap sample ID
+        @param pattern_freq pattern frequencies
+    */
+    void setBootSample(int sample, IntVector &pattern_freq);
+
+    /** @return frequency of a pattern in a bootstrap alignment */
+    int getBootSampleCount(int sample, size_t ptn);
+
+    /**
+        compute the RELL of consecutive bootstrap samples stored as 8-bit counts
+        @param pattern_lh pattern log-likelihoods, padded with zeros
+        @param sample first bootstrap sample
+        @param nvec number of bootstrap samples, at most RELL_BATCH
+        @param nptn number of patterns
+        @param[out] rell RELL of the bootstrap samples
+    */
+    void computeBootCountRELL(BootValType *pattern_lh, int sample, int nvec, int nptn, BootValType *rell);
+
     /** starting sample for UFBoot, used for MPI */
     int sample_start;
 
@@ -795,6 +846,12 @@ public:
     /** corresponding log-likelihood on original alignment */
     DoubleVector boot_orig_logl;
 
+    /** number of trees for which the RELL of bootstrap samples was updated */
+    int num_rell_trees;
+
+    /** time spent on updating the RELL of bootstrap samples */
+    double rell_time;
+
     /** Set of splits occurring in bootstrap trees */
     vector<SplitGraph*> boot_splits;
 
@@ -854,6 +911,12 @@ protected:
     bool testNNI;
 
     ofstream outNNI;
+
+    /** tree copies for branch-parallel NNI evaluation, one per thread */
+    vector<PhyloTree*> nni_workers;
+
+    /** partial likelihood block size the tree copies were allocated with */
+    size_t nni_workers_lh_bytes;
 protected:
 
     //bool print_tree_lh;
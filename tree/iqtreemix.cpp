@@ -13,6 +13,8 @@ const double MAX_LEN = 1.0;
 const double LIKE_THRES = 0.1; // 10% more in team of likelihood value
 const double WEIGHT_EPSILON = 0.001;
 const int OPTIMIZE_STEPS = 10000;
+// below this amount of work per thread (#patterns x #states), a tree is not worth splitting among threads
+const size_t TREE_PATTERN_STATES_PER_THREAD = 4000;
 
 // Input formats for the tree-mixture model
 // 1. linked models and site rates: GTR+G4+T
@@ -102,6 +104,7 @@ IQTreeMix::IQTreeMix() : IQTree() {
     isLinkSiteRate = true;
     anySiteRate = false;
     isNestedOpenmp = false;
+    isTreeParallel = false;
     rhas_var = nullptr;
     ntree = 0;
 }
@@ -192,6 +195,7 @@ IQTreeMix::IQTreeMix(Params &params, Alignment *aln) : IQTree(aln) {
     isLinkSiteRate = true;
     anySiteRate = false;
     isNestedOpenmp = false;
+    isTreeParallel = false;
     rhas_var = nullptr;
 }
 
@@ -662,13 +666,32 @@ int IQTreeMix::getNumLhCat(SiteLoglType wsl) {
     return ncat;
 }
 
+// compute the likelihood values of tree t along the patterns into _ptn_like_cat
+// prerequisite: storeTree0RHAS() has been invoked for the linked RHAS model
+void IQTreeMix::computeLikelihoodOneTree(int t, bool save_log_value) {
+    double* pattern_lh_tree = _ptn_like_cat + (t * nptn);
+    // save the site rate's tree
+    PhyloTree* ptree = at(t)->getRate()->getTree();
+    // set the tree t as the site rate's tree
+    // and compute the likelihood values
+    at(t)->getRate()->setTree(at(t));
+    if (isLinkSiteRate && t > 0) {
+        // Replace the RHAS variables of tree t by those of tree 0
+        copyRHASfrTree0(t);
+    }
+    at(t)->initializeAllPartialLh();
+    at(t)->clearAllPartialLH();
+    at(t)->computeLikelihood(pattern_lh_tree, save_log_value);
+    // set back the prevoius site rate's tree
+    at(t)->getRate()->setTree(ptree);
+}
+
 // compute the log-likelihood values for every site and tree
 // updated array: _ptn_like_cat
 // update_which_tree: only that tree has been updated
 void IQTreeMix::computeSiteTreeLogLike(int update_which_tree) {
     // cout << "enter IQTreeMix::computeSiteTreeLogLike" << endl;
     // cout << "update_which_tree = " << update_which_tree << endl;
-    PhyloTree* ptree;
     int k,t;
 
     t = update_which_tree;
@@ -681,21 +704,9 @@ void IQTreeMix::computeSiteTreeLogLike(int update_which_tree) {
         storeTree0RHAS();
     }
     
-    // compute likelihood for each tree
+    // compute likelihood for the updated tree
     double* patternlh_tree = _ptn_like_cat + (t*nptn);
-    ptree = at(t)->getRate()->getTree();
-    // set the tree t as the site rate's tree
-    // and compute the likelihood values
-    at(t)->getRate()->setTree(at(t));
-    if (isLinkSiteRate && t > 0) {
-        // Replace the RHAS variables of tree t by those of tree 0
-        copyRHASfrTree0(t);
-    }
-    at(t)->initializeAllPartialLh();
-    at(t)->clearAllPartialLH();
-    at(t)->computeLikelihood(patternlh_tree, false);
-    // set back the prevoius site rate's tree
-    at(t)->getRate()->setTree(ptree);
+    computeLikelihoodOneTree(t);
 
     // reorganize the array
     k=t;
@@ -759,49 +770,14 @@ double IQTreeMix::computeLikelihood(double *pattern_lh, bool save_log_value) {
         // Store the RHAS variables of tree 0 to the array rhas_var
         storeTree0RHAS();
     }
-    #ifdef _OPENMP
-    if (isNestedOpenmp) {
-        // omp_set_nested(1);
-        omp_set_max_active_levels(2);
-    }
-    #endif
-
     // compute likelihood for each tree
-    #pragma omp parallel for schedule(static) num_threads(ntree) if (isNestedOpenmp)
+    int loop_threads = startTreeLoop();
+    #pragma omp parallel for schedule(dynamic) num_threads(loop_threads) if (loop_threads > 1)
     for (size_t t=0; t<ntree; t++) {
-        if (isNestedOpenmp) {
-            #ifdef _OPENMP
-            omp_set_num_threads(at(t)->num_threads);
-            #endif
-        }
-        double* pattern_lh_tree = _ptn_like_cat + (nptn * t);
-        // save the site rate's tree
-        PhyloTree* ptree = at(t)->getRate()->getTree();
-        // set the tree t as the site rate's tree
-        // and compute the likelihood values
-        at(t)->getRate()->setTree(at(t));
-        
-        if (isLinkSiteRate && t > 0) {
-            // Replace the RHAS variables of tree t by those of tree 0
-            copyRHASfrTree0(t);
-        }
-        
-        at(t)->initializeAllPartialLh();
-        at(t)->clearAllPartialLH();
-        at(t)->computeLikelihood(pattern_lh_tree, false);
-        // set back the prevoius site rate's tree
-        at(t)->getRate()->setTree(ptree);
+        setTreeLoopThreads(t);
+        computeLikelihoodOneTree(t);
     }
-
-    #ifdef _OPENMP
-    if (isNestedOpenmp) {
-        // omp_set_nested(0);
-        #ifdef _OPENMP
-        omp_set_max_active_levels(1);
-        omp_set_num_threads(num_threads);
-        #endif
-    }
-    #endif
+    endTreeLoop();
 
     // reorganize the array
     // #pragma omp parallel for schedule(static) num_threads(num_threads) if (num_threads > 1)
@@ -886,48 +862,13 @@ double IQTreeMix::computePatternLhCat(SiteLoglType wsl) {
 
     if (wsl == WSL_TMIXTURE) {
         // compute likelihood for each tree
-        #ifdef _OPENMP
-        if (isNestedOpenmp) {
-            // omp_set_nested(1);
-            #ifdef _OPENMP
-            omp_set_max_active_levels(2);
-            #endif
-        }
-        #endif
-        #pragma omp parallel for schedule(static) num_threads(ntree) if (isNestedOpenmp)
+        int loop_threads = startTreeLoop();
+        #pragma omp parallel for schedule(dynamic) num_threads(loop_threads) if (loop_threads > 1)
         for (size_t t=0; t<ntree; t++) {
-            #ifdef _OPENMP
-            if (isNestedOpenmp) {
-                #ifdef _OPENMP
-                omp_set_num_threads(at(t)->num_threads);
-                #endif
-            }
-            #endif
-            double* pattern_lh_tree = _ptn_like_cat + (t * nptn);
-            // save the site rate's tree
-            PhyloTree* ptree = at(t)->getRate()->getTree();
-            // set the tree t as the site rate's tree
-            // and compute the likelihood values
-            at(t)->getRate()->setTree(at(t));
-            if (isLinkSiteRate && t > 0) {
-                // Replace the RHAS variables of tree t by those of tree 0
-                copyRHASfrTree0(t);
-            }
-            at(t)->initializeAllPartialLh();
-            at(t)->clearAllPartialLH();
-            at(t)->computeLikelihood(pattern_lh_tree, save_log_value);
-            // set back the prevoius site rate's tree
-            at(t)->getRate()->setTree(ptree);
+            setTreeLoopThreads(t);
+            computeLikelihoodOneTree(t, save_log_value);
         }
-        #ifdef _OPENMP
-        if (isNestedOpenmp) {
-            // omp_set_nested(0);
-            #ifdef _OPENMP
-            omp_set_max_active_levels(1);
-            omp_set_num_threads(num_threads);
-            #endif
-        }
-        #endif
+        endTreeLoop();
 
         // reorganize the array
         // #pragma omp parallel for schedule(static) num_threads(num_threads) if (num_threads > 1)
@@ -994,23 +935,10 @@ double IQTreeMix::computePatternLhCat(SiteLoglType wsl) {
     } else {
         // compute _pattern_lh_cat for each tree
         nmix = at(0)->getModel()->getNMixtures();
-        #ifdef _OPENMP
-        if (isNestedOpenmp) {
-            // omp_set_nested(1);
-            #ifdef _OPENMP
-            omp_set_max_active_levels(2);
-            #endif
-        }
-        #endif
-        #pragma omp parallel for schedule(static) num_threads(ntree) if (isNestedOpenmp)
+        int loop_threads = startTreeLoop();
+        #pragma omp parallel for schedule(dynamic) num_threads(loop_threads) if (loop_threads > 1)
         for (size_t t = 0; t < ntree; t++) {
-            #ifdef _OPENMP
-            if (isNestedOpenmp) {
-                #ifdef _OPENMP
-                omp_set_num_threads(at(t)->num_threads);
-                #endif
-            }
-            #endif
+            setTreeLoopThreads(t);
             if (isLinkSiteRate && t > 0) {
                 // Replace the RHAS variables of tree t by those of tree 0
                 copyRHASfrTree0(t);
@@ -1020,15 +948,7 @@ double IQTreeMix::computePatternLhCat(SiteLoglType wsl) {
             }
             at(t)->computePatternLhCat(wsl);
         }
-        #ifdef _OPENMP
-        if (isNestedOpenmp) {
-            // omp_set_nested(0);
-            #ifdef _OPENMP
-            omp_set_max_active_levels(1);
-            omp_set_num_threads(num_threads);
-            #endif
-        }
-        #endif
+        endTreeLoop();
 
         // compute the overall _pattern_lh_cat
         #pragma omp parallel for schedule(static) num_threads(num_threads) if (num_threads > 1)
@@ -1154,48 +1074,13 @@ void IQTreeMix::computePatternLikelihood(double *pattern_lh, double *cur_logl,
     }
     
     // compute likelihood for each tree
-    #ifdef _OPENMP
-    if (isNestedOpenmp) {
-        // omp_set_nested(1);
-        #ifdef _OPENMP
-        omp_set_max_active_levels(2);
-        #endif
-    }
-    #endif
-    #pragma omp parallel for schedule(static) num_threads(ntree) if (isNestedOpenmp)
+    int loop_threads = startTreeLoop();
+    #pragma omp parallel for schedule(dynamic) num_threads(loop_threads) if (loop_threads > 1)
     for (size_t t=0; t<ntree; t++) {
-        #ifdef _OPENMP
-        if (isNestedOpenmp) {
-            #ifdef _OPENMP
-            omp_set_num_threads(at(t)->num_threads);
-            #endif
-        }
-        #endif
-        double* pattern_lh_tree = _ptn_like_cat + (t * nptn);
-        // save the site rate's tree
-        PhyloTree* ptree = at(t)->getRate()->getTree();
-        // set the tree t as the site rate's tree
-        // and compute the likelihood values
-        at(t)->getRate()->setTree(at(t));
-        if (isLinkSiteRate && t > 0) {
-            // Replace the RHAS variables of tree t by those of tree 0
-            copyRHASfrTree0(t);
-        }
-        at(t)->initializeAllPartialLh();
-        at(t)->clearAllPartialLH();
-        at(t)->computeLikelihood(pattern_lh_tree, false);
-        // set back the prevoius site rate's tree
-        at(t)->getRate()->setTree(ptree);
-    }
-    #ifdef _OPENMP
-    if (isNestedOpenmp) {
-        // omp_set_nested(0);
-        #ifdef _OPENMP
-        omp_set_max_active_levels(1);
-        omp_set_num_threads(num_threads);
-        #endif
+        setTreeLoopThreads(t);
+        computeLikelihoodOneTree(t);
     }
-    #endif
+    endTreeLoop();
 
     // reorganize the array
     #pragma omp parallel for schedule(dynamic) num_threads(num_threads) if (num_threads > 1)
@@ -1314,34 +1199,13 @@ void IQTreeMix::optimizeAllBranchesOneTree(int whichtree, int my_iterations, dou
  */
 double IQTreeMix::optimizeAllBranches(int my_iterations, double tolerance, int maxNRStep) {
 
-    #ifdef _OPENMP
-    if (isNestedOpenmp) {
-        // omp_set_nested(1);
-        #ifdef _OPENMP
-        omp_set_max_active_levels(2);
-        #endif
-    }
-    #endif
-    #pragma omp parallel for schedule(static) num_threads(ntree) if (isNestedOpenmp)
+    int loop_threads = startTreeLoop();
+    #pragma omp parallel for schedule(dynamic) num_threads(loop_threads) if (loop_threads > 1)
     for (size_t i=0; i<ntree; i++) {
-        #ifdef _OPENMP
-        if (isNestedOpenmp) {
-            #ifdef _OPENMP
-            omp_set_num_threads(at(i)->num_threads);
-            #endif
-        }
-        #endif
+        setTreeLoopThreads(i);
         optimizeAllBranchesOneTree(i, my_iterations, tolerance, maxNRStep);
     }
-    #ifdef _OPENMP
-    if (isNestedOpenmp) {
-        // omp_set_nested(0);
-        #ifdef _OPENMP
-        omp_set_max_active_levels(1);
-        omp_set_num_threads(num_threads);
-        #endif
-    }
-    #endif
+    endTreeLoop();
 
     return computeLikelihood();
 }
@@ -1894,28 +1758,9 @@ uint64_t IQTreeMix::getMemoryRequired(size_t ncategory, bool full_mem) {
 
 // get memory requirement for ModelFinder
 uint64_t IQTreeMix::getMemoryRequiredThreaded(size_t ncategory, bool full_mem) {
-    // only get the largest k partitions (k=#threads)
-    int threads = (params->num_threads != 0) ? params->num_threads : params->num_threads_max;
-    threads = min(threads, countPhysicalCPUCores());
-    threads = min(threads, (int)size());
-    
-    // sort partition by computational cost for OpenMP effciency
-    uint64_t *part_mem = new uint64_t[size()];
-    int i;
-    for (i = 0; i < size(); i++) {
-        part_mem[i] = at(i)->getMemoryRequired(ncategory, full_mem);
-    }
-    
-    // sort partition memory in increasing order
-    quicksort<uint64_t, int>(part_mem, 0, size()-1);
-    
-    uint64_t mem = 0;
-    for (i = size()-threads; i < size(); i++)
-        mem += part_mem[i];
-    
-    delete [] part_mem;
-    
-    return mem;
+    // all trees keep their partial likelihood vectors at the same time,
+    // whether they are computed one after another or in parallel
+    return getMemoryRequired(ncategory, full_mem);
 }
 
 void IQTreeMix::setNumThreads(int num_threads) {
@@ -1946,10 +1791,55 @@ void IQTreeMix::setNumThreads(int num_threads) {
         cout << endl;
         delete[] nthreads;
         isNestedOpenmp = true;
+        isTreeParallel = false;
     } else {
         for (size_t i = 0; i < size(); i++)
             at(i)->setNumThreads(num_threads);
+        isNestedOpenmp = false;
+        // with fewer threads than trees, give each thread whole trees, unless the trees
+        // cannot be evenly distributed while each tree has enough patterns to be split
+        size_t work = getAlnNPattern() * aln->num_states;
+        isTreeParallel = (this->num_threads > 1) &&
+            (size() % this->num_threads == 0 || work < TREE_PATTERN_STATES_PER_THREAD * this->num_threads);
+    }
+}
+
+int IQTreeMix::startTreeLoop() {
+#ifdef _OPENMP
+    if (isNestedOpenmp) {
+        // omp_set_nested(1);
+        omp_set_max_active_levels(2);
+        return ntree;
+    }
+    if (isTreeParallel) {
+        // one thread per tree, each tree keeps its own buffers for the pattern packets
+        for (size_t t = 0; t < ntree; t++)
+            at(t)->num_threads = 1;
+        return num_threads;
     }
+#endif
+    return 1;
+}
+
+void IQTreeMix::setTreeLoopThreads(int t) {
+#ifdef _OPENMP
+    if (isNestedOpenmp)
+        omp_set_num_threads(at(t)->num_threads);
+#endif
+}
+
+void IQTreeMix::endTreeLoop() {
+#ifdef _OPENMP
+    if (isNestedOpenmp) {
+        // omp_set_nested(0);
+        omp_set_max_active_levels(1);
+        omp_set_num_threads(num_threads);
+    }
+    if (isTreeParallel) {
+        for (size_t t = 0; t < ntree; t++)
+            at(t)->setNumThreads(num_threads);
+    }
+#endif
 }
 
 /**
@@ -3050,6 +2940,50 @@ double IQTreeMix::targetFunk(double x[]) {
     return score;
 }
 
+double IQTreeMix::derivativeFunk(double x[], double dfx[]) {
+    if (optim_type != 1)
+        return IQTree::derivativeFunk(x, dfx);
+
+    // tree weights w_t = x_g / S with S = sum_g x_g * |g|, thus for each weight group g
+    // d(-logL)/dx_g = -(sum_ptn freq * L_g / L - |g| * sum_ptn freq) / S,
+    // where L_g is the sum of the likelihoods of the trees in g
+    size_t ndim = weight_group_member.size();
+    getVariables(x);
+    IntVector tree_group(ntree, 0);
+    double sum = 0.0;
+    for (size_t i=0; i<ndim; i++) {
+        for (size_t j=0; j<weight_group_member[i].size(); j++)
+            tree_group[weight_group_member[i].at(j)] = i;
+        sum += tmp_weights[i] * weight_group_member[i].size();
+    }
+
+    double logLike = 0.0;
+    double sum_freq = 0.0;
+    DoubleVector grad(ndim, 0.0);
+    #pragma omp parallel num_threads(num_threads) if (num_threads > 1)
+    {
+        DoubleVector grad_thread(ndim, 0.0);
+        #pragma omp for schedule(static) reduction(+:logLike,sum_freq)
+        for (size_t ptn=0; ptn<nptn; ptn++) {
+            const double* pattern_lh_tree = ptn_like_cat + (ntree * ptn);
+            double subLike = 0.0;
+            for (size_t t=0; t<ntree; t++)
+                subLike += pattern_lh_tree[t] * weights[t];
+            logLike += (log(subLike) + _pattern_scaling[ptn]) * ptn_freq[ptn];
+            sum_freq += ptn_freq[ptn];
+            double ratio = ptn_freq[ptn] / subLike;
+            for (size_t t=0; t<ntree; t++)
+                grad_thread[tree_group[t]] += pattern_lh_tree[t] * ratio;
+        }
+        #pragma omp critical
+        for (size_t i=0; i<ndim; i++)
+            grad[i] += grad_thread[i];
+    }
+    for (size_t i=0; i<ndim; i++)
+        dfx[i+1] = -(grad[i] - weight_group_member[i].size() * sum_freq) / sum;
+    return -logLike;
+}
+
 // read the tree weights and write into "variables"
 void IQTreeMix::setVariables(double *variables) {
     // for tree weights
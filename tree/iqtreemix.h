@@ -67,6 +67,9 @@ public:
     // update_which_tree: only that tree has been updated
     void computeSiteTreeLogLike(int update_which_tree);
 
+    // compute the likelihood values of tree t along the patterns into _ptn_like_cat
+    void computeLikelihoodOneTree(int t, bool save_log_value = false);
+
     virtual double computeLikelihood(double *pattern_lh = nullptr, bool save_log_value = true) override;
 
     virtual double computePatternLhCat(SiteLoglType wsl) override;
@@ -461,6 +464,10 @@ protected:
 
     double targetFunk(double x[]) override;
 
+    // analytical gradient of targetFunk on tree weights from the stored
+    // pattern likelihoods of the trees, numerical gradient otherwise
+    double derivativeFunk(double x[], double dfx[]) override;
+
     // read the tree weights and write into "variables"
     void setVariables(double *variables);
 
@@ -558,6 +565,27 @@ protected:
      */
     bool isNestedOpenmp;
 
+    /**
+     with fewer threads than trees, the trees are computed in parallel with one thread each
+     */
+    bool isTreeParallel;
+
+    /**
+     prepare the threads of the trees for an OpenMP loop over the trees
+     @return number of threads of the loop
+     */
+    int startTreeLoop();
+
+    /**
+     set the number of OpenMP threads of tree t inside the loop over the trees
+     */
+    void setTreeLoopThreads(int t);
+
+    /**
+     restore the threads of the trees after the loop over the trees
+     */
+    void endTreeLoop();
+
     /**
      variables for the shared RHAS model
      */
@@ -354,9 +354,13 @@ void MTreeSet::convertSplits(SplitGraph &sg, double split_threshold, int weighti
 	}*/
 	//SplitGraph temp;
 	convertSplits(sg, hash_ss, weighting_type, weight_threshold);
+	discardRareSplits(sg, hash_ss, split_threshold, size());
+}
+
+void MTreeSet::discardRareSplits(SplitGraph &sg, SplitIntMap &hash_ss, double split_threshold, int ntrees) {
 	int nsplits = sg.getNSplits();
+	double threshold = split_threshold * ntrees;
 
-	double threshold = split_threshold * size();
 //	cout << "threshold = " << threshold << endl;
 	int count=0;
 	for (SplitGraph::iterator it = sg.begin(); it != sg.end(); ) {
@@ -515,8 +519,13 @@ void MTreeSet::convertSplits(vector<string> &taxname, SplitGraph &sg, SplitIntMa
 		}
 	}
 
+	discardLightSplits(sg, weight_threshold);
+	//sg.report(cout);
+}
+
+void MTreeSet::discardLightSplits(SplitGraph &sg, double weight_threshold) {
 	int discarded = 0;	
-	for (itg = sg.begin(); itg != sg.end(); )  {
+	for (SplitGraph::iterator itg = sg.begin(); itg != sg.end(); )  {
 		if ((*itg)->getWeight() <= weight_threshold) {
 			discarded++;
 			delete (*itg);
@@ -526,7 +535,6 @@ void MTreeSet::convertSplits(vector<string> &taxname, SplitGraph &sg, SplitIntMa
 	}
 	if (discarded)
 		cout << discarded << " split(s) discarded because weight <= " << weight_threshold << endl;
-	//sg.report(cout);
 }
 
 
@@ -540,6 +548,107 @@ MTreeSet::~MTreeSet()
 }
 
 
+/** number of trees converted into splits at once, bounding the memory of the split graphs */
+const size_t SPLIT_ID_BATCH = 1024;
+
+void MTreeSet::convertSplitIDs(SplitGraph &split_table, SplitIntMap &split_ids, vector<IntVector> &tree_splits,
+	double weight_threshold, IntVector *num_trivial)
+{
+	size_t ntree = size();
+	size_t first = tree_splits.size();
+	tree_splits.resize(first + ntree);
+	if (num_trivial) num_trivial->resize(first + ntree, 0);
+	vector<SplitGraph*> sg_batch;
+	for (size_t batch_start = 0; batch_start < ntree; batch_start += SPLIT_ID_BATCH) {
+		size_t batch_end = min(ntree, batch_start + SPLIT_ID_BATCH);
+		sg_batch.resize(batch_end - batch_start);
+		// converting trees into split system in parallel
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+		for (size_t id = batch_start; id < batch_end; id++) {
+			SplitGraph *sg = new SplitGraph();
+			Split sp(at(id)->leafNum);
+			at(id)->convertSplits(*sg, &sp);
+			// make sure that taxon 0 is included
+			for (SplitGraph::iterator sit = sg->begin(); sit != sg->end(); sit++) {
+				if (!(*sit)->containTaxon(0)) (*sit)->invert();
+			}
+			sg_batch[id - batch_start] = sg;
+		}
+		// each distinct split is stored once and identified by its index
+		for (size_t id = batch_start; id < batch_end; id++) {
+			SplitGraph *sg = sg_batch[id - batch_start];
+			IntVector &splits = tree_splits[first + id];
+			splits.reserve(sg->size());
+			for (SplitGraph::iterator sit = sg->begin(); sit != sg->end(); sit++) {
+				bool heavy = (*sit)->getWeight() >= weight_threshold;
+				if (num_trivial && (*sit)->trivial() >= 0)
+					(*num_trivial)[first + id]++;
+				int split_id;
+				if (!split_ids.findSplit(*sit, split_id)) {
+					split_id = split_table.size();
+					split_table.push_back(*sit);
+					split_ids.insertSplit(*sit, split_id);
+					(*sit) = nullptr;
+				}
+				splits.push_back(split_id*2 + heavy);
+			}
+			sort(splits.begin(), splits.end());
+			delete sg;
+		}
+	}
+}
+
+/**
+	@param splits1 sorted split IDs of the first tree, see MTreeSet::convertSplitIDs()
+	@param splits2 sorted split IDs of the second tree
+	@return number of splits with weight above the threshold in one tree but not in the other
+*/
+static int countDiffSplits(IntVector &splits1, IntVector &splits2) {
+	int diff_splits = 0;
+	IntVector::iterator it1 = splits1.begin(), it2 = splits2.begin();
+	while (it1 != splits1.end() && it2 != splits2.end()) {
+		if (((*it1) >> 1) < ((*it2) >> 1)) {
+			diff_splits += (*it1) & 1;
+			it1++;
+		} else if (((*it1) >> 1) > ((*it2) >> 1)) {
+			diff_splits += (*it2) & 1;
+			it2++;
+		} else {
+			it1++;
+			it2++;
+		}
+	}
+	for (; it1 != splits1.end(); it1++)
+		diff_splits += (*it1) & 1;
+	for (; it2 != splits2.end(); it2++)
+		diff_splits += (*it2) & 1;
+	return diff_splits;
+}
+
+/**
+	@param splits1 sorted split IDs of the first tree, see MTreeSet::convertSplitIDs()
+	@param splits2 sorted split IDs of the second tree
+	@return number of splits shared by both trees
+*/
+static int countCommonSplits(IntVector &splits1, IntVector &splits2) {
+	int common_splits = 0;
+	IntVector::iterator it1 = splits1.begin(), it2 = splits2.begin();
+	while (it1 != splits1.end() && it2 != splits2.end()) {
+		if (((*it1) >> 1) < ((*it2) >> 1)) {
+			it1++;
+		} else if (((*it1) >> 1) > ((*it2) >> 1)) {
+			it2++;
+		} else {
+			common_splits++;
+			it1++;
+			it2++;
+		}
+	}
+	return common_splits;
+}
+
 void MTreeSet::computeRFDist(double *rfdist, int mode, double weight_threshold) {
 	// exit if less than 2 trees
 	if (size() < 2)
@@ -553,57 +662,62 @@ void MTreeSet::computeRFDist(double *rfdist, int mode, double weight_threshold)
     }
 	cout << "Computing Robinson-Foulds distance..." << endl;
 
-	vector<string> taxname(front()->leafNum);
-	vector<SplitIntMap*> hs_vec;
-	vector<SplitGraph*> sg_vec;
-
-	front()->getTaxaName(taxname);
-
+	// converting trees into sorted split IDs for efficiency
+	SplitGraph split_table;
+	SplitIntMap split_ids;
+	vector<IntVector> tree_splits;
+	convertSplitIDs(split_table, split_ids, tree_splits, weight_threshold);
+	if (verbose_mode >= VB_MED)
+		cout << split_table.size() << " distinct splits in " << size() << " trees" << endl;
 
-	// converting trees into split system then stored in SplitIntMap for efficiency
-	for (iterator it = begin(); it != end(); it++) {
-		SplitGraph *sg = new SplitGraph();
-		SplitIntMap *hs = new SplitIntMap();
+	// now start the RF computation
+	computeRFDist(tree_splits, rfdist, mode);
+}
 
-		(*it)->convertSplits(taxname, *sg);
-		// make sure that taxon 0 is included
-		for (SplitGraph::iterator sit = sg->begin(); sit != sg->end(); sit++) {
-			if (!(*sit)->containTaxon(0)) (*sit)->invert();
-			hs->insertSplit((*sit), 1);
+void MTreeSet::computeRFDist(vector<IntVector> &tree_splits, double *rfdist, int mode) {
+	int ntree = tree_splits.size();
+	int nrow = (mode == RF_ADJACENT_PAIR) ? ntree-1 : ntree;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int id = 0; id < nrow; id++) {
+		int end_id = (mode == RF_ADJACENT_PAIR) ? id+2 : ntree;
+		for (int id2 = id+1; id2 < end_id; id2++) {
+			int rf_val = countDiffSplits(tree_splits[id], tree_splits[id2]);
+			if (mode == RF_ADJACENT_PAIR)
+				rfdist[id] = rf_val;
+			else {
+				rfdist[(size_t)id*ntree + id2] = rfdist[(size_t)id2*ntree + id] = rf_val;
+			}
 		}
-		hs_vec.push_back(hs);
-		sg_vec.push_back(sg);
 	}
+}
 
-	// now start the RF computation
-	int id = 0;
-	for (vector<SplitIntMap*>::iterator hsit = hs_vec.begin(); hsit+1 != hs_vec.end(); hsit++, id++) {
-		vector<SplitIntMap*>::iterator end_it = hs_vec.end();
-		if (mode == RF_ADJACENT_PAIR) end_it = hsit+2;
-		int id2 = id+1;
-		for (vector<SplitIntMap*>::iterator hsit2 = hsit+1; hsit2 != end_it; hsit2++, id2++) {
-			int diff_splits = 0;
-			SplitIntMap::iterator spit;
-			for (spit = (*hsit2)->begin(); spit != (*hsit2)->end(); spit++) {
-				if (spit->first->getWeight() >= weight_threshold && !(*hsit)->findSplit(spit->first)) diff_splits++;
-			}
-			for (spit = (*hsit)->begin(); spit != (*hsit)->end(); spit++) {
-				if (spit->first->getWeight() >= weight_threshold && !(*hsit2)->findSplit(spit->first)) diff_splits++;
+void MTreeSet::computeRFDist(vector<IntVector> &tree_splits, int nrow, IntVector &num_trivial, int ntaxa,
+	bool k_by_k, double *rfdist)
+{
+	int col_size = tree_splits.size() - nrow;
+	bool normalize = Params::getInstance().normalize_tree_dist;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int id = 0; id < nrow; id++) {
+		int start_id2 = k_by_k ? id : 0;
+		int end_id2 = k_by_k ? id+1 : col_size;
+		for (int id2 = start_id2; id2 < end_id2; id2++) {
+			IntVector &splits1 = tree_splits[id];
+			IntVector &splits2 = tree_splits[nrow + id2];
+			double rf_val = splits1.size() + splits2.size() - 2*countCommonSplits(splits1, splits2);
+			if (normalize) {
+				int non_trivial = splits1.size() - num_trivial[id] + splits2.size() - ntaxa;
+				rf_val /= non_trivial;
 			}
-			//int rf_val = (*hsit)->size() + (*hsit2)->size() - 2*common_splits;
-			int rf_val = diff_splits;
-			if (mode == RF_ADJACENT_PAIR) 
+			if (k_by_k)
 				rfdist[id] = rf_val;
-			else {
-				rfdist[id*size() + id2] = rfdist[id2*size() + id] = rf_val;
-			}
+			else
+				rfdist[(id*col_size) + id2] = rf_val;
 		}
 	}
-	// delete memory 
-	for (id = size()-1; id >= 0; id--) {
-		delete hs_vec[id];
-		delete sg_vec[id];
-	}
 }
 
 
@@ -618,6 +732,18 @@ void MTreeSet::computeRFDist(double *rfdist, MTreeSet *treeset2, bool k_by_k,
 	cout << "Using map" << endl;
 #endif
     }
+	if (!info_file && !tree_file && !incomp_splits) {
+		// converting both tree sets into sorted split IDs for efficiency
+		SplitGraph split_table;
+		SplitIntMap split_ids;
+		vector<IntVector> tree_splits;
+		IntVector num_trivial;
+		convertSplitIDs(split_table, split_ids, tree_splits, -1000, &num_trivial);
+		treeset2->convertSplitIDs(split_table, split_ids, tree_splits);
+		computeRFDist(tree_splits, size(), num_trivial, front()->leafNum, k_by_k, rfdist);
+		return;
+	}
+
 	ofstream oinfo;
 	ofstream otree;
 	if (info_file) oinfo.open(info_file);
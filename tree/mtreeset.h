@@ -174,6 +174,52 @@ public:
 	void computeRFDist(double *rfdist, MTreeSet *treeset2, bool k_by_k,
 		const char* info_file = nullptr, const char *tree_file = nullptr, double *incomp_splits = nullptr);
 
+	/**
+		convert trees into sorted vectors of split IDs for fast tree comparison.
+		Each distinct split, normalised to contain taxon 0, is hashed once into split_ids
+		@param[in,out] split_table distinct splits owning the Split objects, shared among tree sets
+		@param[in,out] split_ids hash map from distinct splits to their index in split_table
+		@param[out] tree_splits for each tree appended, sorted split IDs times 2, plus 1 if the split weight >= weight_threshold
+		@param weight_threshold minimum weight cutoff
+		@param[out] num_trivial number of trivial splits of each tree appended, if not nullptr
+	*/
+	void convertSplitIDs(SplitGraph &split_table, SplitIntMap &split_ids, vector<IntVector> &tree_splits,
+		double weight_threshold = -1000, IntVector *num_trivial = nullptr);
+
+	/**
+		compute the Robinson-Foulds distance between trees given as split IDs, see convertSplitIDs()
+		@param tree_splits sorted split IDs of each tree
+		@param rfdist (OUT) RF distance
+		@param mode RF_ALL_PAIR or RF_ADJACENT_PAIR
+	*/
+	static void computeRFDist(vector<IntVector> &tree_splits, double *rfdist, int mode);
+
+	/**
+		compute the Robinson-Foulds distance between two tree sets given as split IDs, see convertSplitIDs()
+		@param tree_splits sorted split IDs of the first nrow trees followed by the trees of the second set
+		@param nrow number of trees in the first set
+		@param num_trivial number of trivial splits of each tree in the first set
+		@param ntaxa number of taxa
+		@param k_by_k true to compute distances between corresponding k-th tree of two tree sets,
+			false to do all-by-all
+		@param[out] rfdist output RF distance
+	*/
+	static void computeRFDist(vector<IntVector> &tree_splits, int nrow, IntVector &num_trivial, int ntaxa,
+		bool k_by_k, double *rfdist);
+
+	/**
+		remove splits with weight <= weight_threshold from a split graph
+	*/
+	static void discardLightSplits(SplitGraph &sg, double weight_threshold);
+
+	/**
+		remove splits occurring in no more than split_threshold * ntrees trees from a split graph
+		@param hash_ss hash split set of sg with the number of occurrences of each split
+		@param split_threshold minimum split frequency
+		@param ntrees number of trees
+	*/
+	static void discardRareSplits(SplitGraph &sg, SplitIntMap &hash_ss, double split_threshold, int ntrees);
+
 	int categorizeDistinctTrees(IntVector &category);
 
 	int sumTreeWeights();
@@ -6,9 +6,169 @@
 //
 
 #include "phylohmm.h"
+#include <vectorclass/vectormath_exp.h>
+#include <vectorclass/vectorclass.h>
+
+// compute the log of dotproduct of the logorithm arrays
+double logDotProd(const double* ln_x, const double* ln_y, int n) {
+    int step = Vec2d::size();
+    int integralSize = n - (n & (step - 1));
+    int i;
+    Vec2d a, b;
+    // find the max
+    double max_w = ln_x[0] + ln_y[0];
+    if (integralSize > 0) {
+        Vec2d vmax(max_w);
+        for (i = 0; i < integralSize; i += step) {
+            a.load(ln_x + i);
+            b.load(ln_y + i);
+            vmax = max(vmax, a + b);
+        }
+        max_w = max(vmax.extract(0), vmax.extract(1));
+    }
+    for (i = integralSize; i < n; i++)
+        max_w = max(max_w, ln_x[i] + ln_y[i]);
+    // compute the dotproduct
+    double ans = 0.0;
+    if (integralSize > 0) {
+        Vec2d vsum(0.0), vmax(max_w);
+        for (i = 0; i < integralSize; i += step) {
+            a.load(ln_x + i);
+            b.load(ln_y + i);
+            vsum += exp(a + b - vmax);
+        }
+        ans = horizontal_add(vsum);
+    }
+    for (i = integralSize; i < n; i++)
+        ans += exp(ln_x[i] + ln_y[i] - max_w);
+    return log(ans) + max_w;
+}
+
+// dest[i] = exp(source[i] - shift)
+static inline void expShift(const double* source, double shift, double* dest, int n) {
+    int step = Vec2d::size();
+    int integralSize = n - (n & (step - 1));
+    int i;
+    Vec2d v, vshift(shift);
+    for (i = 0; i < integralSize; i += step) {
+        v.load(source + i);
+        exp(v - vshift).store(dest + i);
+    }
+    for (; i < n; i++)
+        dest[i] = exp(source[i] - shift);
+}
+
+// dest[i] = log(source[i]) + shift
+static inline void logShift(const double* source, double shift, double* dest, int n) {
+    int step = Vec2d::size();
+    int integralSize = n - (n & (step - 1));
+    int i;
+    Vec2d v, vshift(shift);
+    for (i = 0; i < integralSize; i += step) {
+        v.load(source + i);
+        (log(v) + vshift).store(dest + i);
+    }
+    for (; i < n; i++)
+        dest[i] = log(source[i]) + shift;
+}
+
+// @return the maximum of the array
+static inline double maxArray(const double* x, int n) {
+    double max_x = x[0];
+    for (int i = 1; i < n; i++)
+        max_x = max(max_x, x[i]);
+    return max_x;
+}
+
+// @return the dotproduct of the arrays
+static inline double dotProd(const double* x, const double* y, int n) {
+    int step = Vec2d::size();
+    int integralSize = n - (n & (step - 1));
+    int i;
+    Vec2d a, b, vsum(0.0);
+    for (i = 0; i < integralSize; i += step) {
+        a.load(x + i);
+        b.load(y + i);
+        vsum = mul_add(a, b, vsum);
+    }
+    double ans = horizontal_add(vsum);
+    for (; i < n; i++)
+        ans += x[i] * y[i];
+    return ans;
+}
+
+// @return max_i(ln_x[i] + ln_y[i]), and the first i with the max value in max_i
+static inline double maxProd(const double* ln_x, const double* ln_y, int n, int &max_i) {
+    int step = Vec2d::size();
+    int integralSize = n - (n & (step - 1));
+    int i;
+    double max_w = ln_x[0] + ln_y[0];
+    max_i = 0;
+    if (integralSize > 0) {
+        // the max of each lane and its first index
+        Vec2d a, b, w, vmax(max_w), vidx(0.0), idx(0.0, 1.0);
+        for (i = 0; i < integralSize; i += step) {
+            a.load(ln_x + i);
+            b.load(ln_y + i);
+            w = a + b;
+            Vec2db greater = w > vmax;
+            vmax = select(greater, w, vmax);
+            vidx = select(greater, idx, vidx);
+            idx += (double)step;
+        }
+        max_w = vmax.extract(0);
+        max_i = (int)vidx.extract(0);
+        if (vmax.extract(1) > max_w || (vmax.extract(1) == max_w && vidx.extract(1) < max_i)) {
+            max_w = vmax.extract(1);
+            max_i = (int)vidx.extract(1);
+        }
+    }
+    for (i = integralSize; i < n; i++)
+        if (max_w < ln_x[i] + ln_y[i]) {
+            max_w = ln_x[i] + ln_y[i];
+            max_i = i;
+        }
+    return max_w;
+}
+
+// one step of the recursions in log space, using the transition matrix in linear space
+// work[j] = log(sum_l transit[j*ncat+l] * exp(pre_work[l])) + site_lh[j]
+// the max of pre_work is factored out, so that only ncat exp and log are needed
+// @param tmp working array of size ncat
+static inline void logStep(const double* transit, const double* pre_work, const double* site_lh,
+                           double* work, double* tmp, int ncat) {
+    double pre_max = maxArray(pre_work, ncat);
+    expShift(pre_work, pre_max, tmp, ncat);
+    for (int j = 0; j < ncat; j++) {
+        work[j] = dotProd(transit, tmp, ncat);
+        transit += ncat;
+    }
+    logShift(work, pre_max, work, ncat);
+    for (int j = 0; j < ncat; j++)
+        work[j] += site_lh[j];
+}
+
+// one step of the recursions in linear space, where pre_work and work hold scaled likelihoods
+// work[j] = exp(site_lh[j]) * sum_l transit[j*ncat+l] * pre_work[l], scaled to max_j(work[j]) = 1
+// @return log of the scaling factor
+static inline double linearStep(const double* transit, const double* pre_work, const double* site_lh,
+                                double* work, int ncat) {
+    double site_max = maxArray(site_lh, ncat);
+    expShift(site_lh, site_max, work, ncat);
+    for (int j = 0; j < ncat; j++) {
+        work[j] *= dotProd(transit, pre_work, ncat);
+        transit += ncat;
+    }
+    double scale = maxArray(work, ncat);
+    double inv_scale = 1.0 / scale;
+    for (int j = 0; j < ncat; j++)
+        work[j] *= inv_scale;
+    return log(scale) + site_max;
+}
 
 PhyloHmm::PhyloHmm() {
     nsite = ncat = 0;
+    linear_space = false;
     prob = nullptr;
     prob_log = nullptr;
     site_like_cat = nullptr;
@@ -25,6 +185,7 @@ PhyloHmm::PhyloHmm(int n_site, int n_cat) {
     
     nsite = n_site;
     ncat = n_cat;
+    linear_space = Params::getInstance().HMM_linear_space;
     
     // allocate memory for the arrays
     size_t prob_size = get_safe_upper_limit(ncat);
@@ -35,7 +196,7 @@ PhyloHmm::PhyloHmm(int n_site, int n_cat) {
     prob_log = aligned_alloc<double>(prob_size);
     site_like_cat = aligned_alloc<double>(site_like_cat_size);
     site_categories = aligned_alloc<int>(get_safe_upper_limit(nsite));
-    work_arr = aligned_alloc<double>(prob_size * 2);
+    work_arr = aligned_alloc<double>(prob_size * 3);
     next_cat = aligned_alloc<int>(site_like_cat_size);
     
     // allocate memory for the backward and forward algorithm
@@ -70,10 +231,10 @@ PhyloHmm::~PhyloHmm() {
     delete(modelHmm);
 }
 
-// compute backward log-likelihood
+// backward recursion over all sites in work_arr
 // prerequisite: array site_like_cat has been updated (i.e. computeLogLikelihoodSiteTree() has been invoked)
 // note: site_like_cat[i * ntree + j] : log-likelihood of site nsite-i-1 and tree j
-double PhyloHmm::computeBackLike(bool showInterRst) {
+double* PhyloHmm::computeBackWork(double &log_scale, bool showInterRst) {
     int showlines = 5;
     size_t pre_k = 0;
     size_t k;
@@ -81,19 +242,24 @@ double PhyloHmm::computeBackLike(bool showInterRst) {
     double* pre_work;
     double* work;
     double* site_lh_arr;
-    double* transit_arr;
     site_lh_arr = site_like_cat;
-    memcpy(work_arr, site_lh_arr, sizeof(double) * ncat);
+    log_scale = 0.0;
+    clearTransitLinear();
+    if (linear_space) {
+        log_scale = maxArray(site_lh_arr, ncat);
+        expShift(site_lh_arr, log_scale, work_arr, ncat);
+    } else {
+        memcpy(work_arr, site_lh_arr, sizeof(double) * ncat);
+    }
     pre_work = work_arr;
     for (i = 1; i < nsite; i++) {
-        k = (pre_k + 1) % 2;
+        k = pre_k ^ 1;
         work = work_arr + k * ncat;
         site_lh_arr += ncat;
-        transit_arr = modelHmm->getTransitLog(nsite-i);
-        for (j = 0; j < ncat; j++) {
-            work[j] = logDotProd(transit_arr, pre_work, ncat) + site_lh_arr[j];
-            transit_arr += ncat;
-        }
+        if (linear_space)
+            log_scale += linearStep(getTransitLinear(nsite-i), pre_work, site_lh_arr, work, ncat);
+        else
+            logStep(getTransitLinear(nsite-i), pre_work, site_lh_arr, work, work_arr + 2 * ncat, ncat);
         pre_k = k;
         pre_work = work;
         // show the intermediate results
@@ -101,18 +267,28 @@ double PhyloHmm::computeBackLike(bool showInterRst) {
             for (j = 0; j < ncat; j++) {
                 if (j > 0)
                     cout << "\t";
-                cout << work[j];
+                cout << (linear_space ? log(work[j]) + log_scale : work[j]);
             }
             cout << endl;
         }
     }
-    return logDotProd(prob_log, pre_work, ncat);
+    return pre_work;
+}
+
+// compute backward log-likelihood
+// prerequisite: array site_like_cat has been updated (i.e. computeLogLikelihoodSiteTree() has been invoked)
+double PhyloHmm::computeBackLike(bool showInterRst) {
+    double log_scale;
+    double* work = computeBackWork(log_scale, showInterRst);
+    if (linear_space)
+        return log(dotProd(prob, work, ncat)) + log_scale;
+    return logDotProd(prob_log, work, ncat);
 }
 
 // path with max log-likelihood
 double PhyloHmm::computeMaxPath() {
     size_t pre_k = 0;
-    size_t i,j,k,l;
+    size_t i,j,k;
     double* pre_work;
     double* work;
     double* site_lh_arr;
@@ -130,16 +306,7 @@ double PhyloHmm::computeMaxPath() {
         transit_arr = modelHmm->getTransitLog(i);
         next_cat_arr = next_cat + (nsite - i - 1) * ncat;
         for (j = 0; j < ncat; j++) {
-            work[j] = transit_arr[0] + pre_work[0];
-            next_cat_arr[j] = 0;
-            for (l = 1; l < ncat; l++) {
-                v = transit_arr[l] + pre_work[l];
-                if (work[j] < v) {
-                    work[j] = v;
-                    next_cat_arr[j] = (int) l;
-                }
-            }
-            work[j] += site_lh_arr[j];
+            work[j] = maxProd(transit_arr, pre_work, ncat, next_cat_arr[j]) + site_lh_arr[j];
             transit_arr += ncat;
         }
         pre_k = k;
@@ -175,50 +342,36 @@ double PhyloHmm::computeMaxPath() {
 
 // optimize probabilities using EM algorithm
 double PhyloHmm::optimizeProbEM() {
-    size_t pre_k = 0;
-    size_t k;
-    size_t i,j;
-    double* pre_work;
-    double* work;
-    double* site_lh_arr;
-    double* transit_arr;
-    site_lh_arr = site_like_cat;
-    memcpy(work_arr, site_lh_arr, sizeof(double) * ncat);
-    pre_work = work_arr;
-    for (i = 1; i < nsite; i++) {
-        k = pre_k ^ 1;
-        work = work_arr + k * ncat;
-        site_lh_arr += ncat;
-        transit_arr = modelHmm->getTransitLog(nsite-i);
+    size_t j;
+    double log_scale;
+    double* pre_work = computeBackWork(log_scale);
+    double* work = (pre_work == work_arr) ? work_arr + ncat : work_arr;
+
+    if (linear_space) {
         for (j = 0; j < ncat; j++) {
-            work[j] = logDotProd(transit_arr, pre_work, ncat) + site_lh_arr[j];
-            transit_arr += ncat;
+            work[j] = prob[j] * pre_work[j];
         }
-        pre_k = k;
-        pre_work = work;
-    }
-    
-    k = pre_k ^ 1;
-    work = work_arr + k * ncat;
-    // compute the max among prob_log[0]+work[0],prob_log[1]+work[1],...
-    for (j = 0; j < ncat; j++) {
-        work[j] = prob_log[j] + pre_work[j];
-    }
-    double max = work[0];
-    int max_j = 0;
-    for (j = 1; j < ncat; j++) {
-        if (max < work[j]) {
-            max = work[j];
-            max_j = (int) j;
+    } else {
+        // compute the max among prob_log[0]+work[0],prob_log[1]+work[1],...
+        for (j = 0; j < ncat; j++) {
+            work[j] = prob_log[j] + pre_work[j];
+        }
+        double max = work[0];
+        int max_j = 0;
+        for (j = 1; j < ncat; j++) {
+            if (max < work[j]) {
+                max = work[j];
+                max_j = (int) j;
+            }
+        }
+        // exp(prob_log[i] + work[i] - max)
+        for (j = 0; j < max_j; j++) {
+            work[j] = exp(work[j] - max);
+        }
+        work[max_j] = 1.0;
+        for (j = max_j+1; j < ncat; j++) {
+            work[j] = exp(work[j] - max);
         }
-    }
-    // exp(prob_log[i] + work[i] - max)
-    for (j = 0; j < max_j; j++) {
-        work[j] = exp(work[j] - max);
-    }
-    work[max_j] = 1.0;
-    for (j = max_j+1; j < ncat; j++) {
-        work[j] = exp(work[j] - max);
     }
     // compute the sum of them
     double sum_like = 0.0;
@@ -252,6 +405,8 @@ double PhyloHmm::optimizeProbEM() {
     }
     computeLogProb();
     
+    if (linear_space)
+        return log(dotProd(prob, pre_work, ncat)) + log_scale;
     return logDotProd(prob_log, pre_work, ncat);
 }
 
@@ -377,6 +532,25 @@ void PhyloHmm::showSiteCatMaxLike(ostream& out, bool show_assignment, int cat_as
     delete[] rateSites;
 }
 
+// clear the transition matrices in linear space, as modelHmm may have changed
+void PhyloHmm::clearTransitLinear() {
+    transit_linear.clear();
+    transit_offset.clear();
+}
+
+// @return the transition matrix between site_i and the next site, in linear space
+double* PhyloHmm::getTransitLinear(int site_i) {
+    double* transit_log = modelHmm->getTransitLog(site_i);
+    auto it = transit_offset.find(transit_log);
+    if (it == transit_offset.end()) {
+        size_t offset = transit_linear.size();
+        transit_linear.resize(offset + ncat * ncat);
+        expShift(transit_log, 0.0, &transit_linear[offset], ncat * ncat);
+        it = transit_offset.insert({transit_log, offset}).first;
+    }
+    return &transit_linear[it->second];
+}
+
 // compute the log values of prob
 void PhyloHmm::computeLogProb() {
     size_t i;
@@ -389,25 +563,33 @@ void PhyloHmm::computeLogProb() {
 // prerequisite: array site_like_cat has been updated (i.e. computeLogLikelihoodSiteTree() has been invoked)
 // and save all the intermediate results to the bwd_array array
 double PhyloHmm::computeBackLikeArray() {
-    // pre_k is never used
-    // size_t pre_k = 0;
-    size_t k;
     double* pre_work;
     double* work;
     double* site_lh_arr;
-    double* transit_arr;
     double score;
+    // scaled likelihoods in linear space
+    double* pre_lin;
+    double* lin = work_arr;
+    double log_scale = 0.0;
     site_lh_arr = site_like_cat;
     work = bwd_array + (nsite - 1) * ncat;
     memcpy(work, site_lh_arr, sizeof(double) * ncat);
+    clearTransitLinear();
+    if (linear_space) {
+        log_scale = maxArray(site_lh_arr, ncat);
+        expShift(site_lh_arr, log_scale, lin, ncat);
+    }
     for (int i = nsite - 1; i >= 1; i--) {
         pre_work = work;
         work = bwd_array + (i - 1) * ncat;
-        transit_arr = modelHmm->getTransitLog(i);
         site_lh_arr += ncat;
-        for (int j = 0; j < ncat; j++) {
-            work[j] = logDotProd(transit_arr, pre_work, ncat) + site_lh_arr[j];
-            transit_arr += ncat;
+        if (linear_space) {
+            pre_lin = lin;
+            lin = (pre_lin == work_arr) ? work_arr + ncat : work_arr;
+            log_scale += linearStep(getTransitLinear(i), pre_lin, site_lh_arr, lin, ncat);
+            logShift(lin, log_scale, work, ncat);
+        } else {
+            logStep(getTransitLinear(i), pre_work, site_lh_arr, work, work_arr + 2 * ncat, ncat);
         }
     }
     score = logDotProd(prob_log, work, ncat);
@@ -417,24 +599,31 @@ double PhyloHmm::computeBackLikeArray() {
 // compute forward log-likelihood
 // and save all the intermediate results to the fwd_array array
 double PhyloHmm::computeFwdLikeArray() {
-    // pre_k is never used
-    // size_t pre_k = 0;
-    size_t k;
     double* pre_work;
     double* work;
     double* site_lh_arr;
-    double* transit_arr;
     double score;
+    // scaled likelihoods in linear space
+    double* pre_lin;
+    double* lin = work_arr;
+    double log_scale = 0.0;
     site_lh_arr = site_like_cat + (nsite-1) * ncat;
     work = fwd_array;
     memcpy(work, prob_log, sizeof(double) * ncat);
+    clearTransitLinear();
+    if (linear_space) {
+        memcpy(lin, prob, sizeof(double) * ncat);
+    }
     for (int i = 1; i < nsite; i++) {
         pre_work = work;
         work += ncat;
-        transit_arr = modelHmm->getTransitLog(i);
-        for (int j = 0; j < ncat; j++) {
-            work[j] = logDotProd(transit_arr, pre_work, ncat) + site_lh_arr[j];
-            transit_arr += ncat;
+        if (linear_space) {
+            pre_lin = lin;
+            lin = (pre_lin == work_arr) ? work_arr + ncat : work_arr;
+            log_scale += linearStep(getTransitLinear(i), pre_lin, site_lh_arr, lin, ncat);
+            logShift(lin, log_scale, work, ncat);
+        } else {
+            logStep(getTransitLinear(i), pre_work, site_lh_arr, work, work_arr + 2 * ncat, ncat);
         }
         site_lh_arr -= ncat;
     }
@@ -478,9 +667,11 @@ void PhyloHmm::computeMarginalProb(ostream* out) {
         if (out != nullptr)
             *out << i+1;
         score = logDotProd(f_array, b_array, ncat);
-        for (int j=0; j<ncat; j++) {
-            mprob[j] = exp(f_array[j]+b_array[j]-score);
-            if (out != nullptr)
+        for (int j=0; j<ncat; j++)
+            mprob[j] = f_array[j]+b_array[j];
+        expShift(mprob, score, mprob, ncat);
+        if (out != nullptr) {
+            for (int j=0; j<ncat; j++)
                 *out << "\t" << mprob[j];
         }
         if (out != nullptr)
@@ -522,12 +713,14 @@ void PhyloHmm::computeMarginalTransitProb() {
         score = logDotProd(t1, t2, sq_ncat);
         // cout << "[" << score << "]";
         // sum = 0.0;
-        for (k=0; k<sq_ncat; k++) {
-            mprob[k] = exp(t1[k] + t2[k] - score);
-            // NHANLT: sum is never used since the line " cout << " {" << sum << "}" << endl;" was commented
-            // sum += mprob[k];
-            // cout << " " << mprob[k];
-        }
+        for (k=0; k<sq_ncat; k++)
+            mprob[k] = t1[k] + t2[k];
+        expShift(mprob, score, mprob, sq_ncat);
+        // NHANLT: sum is never used since the line " cout << " {" << sum << "}" << endl;" was commented
+        // for (k=0; k<sq_ncat; k++) {
+        //     sum += mprob[k];
+        //     cout << " " << mprob[k];
+        // }
         // cout << " {" << sum << "}" << endl;
         f_array += ncat;
         b_array += ncat;
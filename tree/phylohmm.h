@@ -16,38 +16,7 @@
 // using namespace std;
 
 // compute the log of dotproduct of the logorithm arrays
-inline double logDotProd(double* ln_x, double* ln_y, int n) {
-    double max;
-    double max_i;
-    size_t i;
-    double* w;
-    double ans;
-    
-    w = new double[n];
-    for (i = 0; i < n; i++) {
-        w[i] = ln_x[i] + ln_y[i];
-    }
-    // find the max
-    max = w[0];
-    max_i = 0;
-    for (i = 1; i < n; i++) {
-        if (max < w[i]) {
-            max = w[i];
-            max_i = i;
-        }
-    }
-    // compute the dotproduct
-    ans = 0.0;
-    for (i = 0; i < max_i; i++) {
-        ans += exp(w[i] - max);
-    }
-    ans += 1.0;
-    for (i = max_i+1; i < n; i++) {
-        ans += exp(w[i] - max);
-    }
-    delete[] w;
-    return log(ans) + max;
-}
+double logDotProd(const double* ln_x, const double* ln_y, int n);
 
 class ModelHmm;
 class ModelHmmGm;
@@ -88,6 +57,9 @@ public:
     
     // number of sites
     int nsite;
+
+    // TRUE to run the recursions with scaled likelihoods instead of log-likelihoods
+    bool linear_space;
     
     // number of categories
     int ncat;
@@ -167,5 +139,21 @@ private:
 
     // compute the log values of prob
     void computeLogProb();
+
+    // backward recursion over all sites in work_arr
+    // @param[out] log_scale log of the scaling factor in linear space, 0 in log space
+    // @return the vector of the first site: log-likelihoods, or scaled likelihoods in linear space
+    double* computeBackWork(double &log_scale, bool showInterRst = false);
+
+    // transition matrices in linear space for the recursions
+    // transit_linear + transit_offset[transitLog] = exp(transitLog) for each transitLog of modelHmm
+    vector<double> transit_linear;
+    unordered_map<double*, size_t> transit_offset;
+
+    // clear the transition matrices in linear space, as modelHmm may have changed
+    void clearTransitLinear();
+
+    // @return the transition matrix between site_i and the next site, in linear space
+    double* getTransitLinear(int site_i);
 };
 #endif
@@ -61,6 +61,41 @@ inline double horizontal_max(Vec4d const &a) {
 
 #endif // __AVX__
 
+/*
+    convert 8-bit counts into a vector of weights, reading 16 counts whatever the vector size.
+    static as the same vector class is compiled for different instruction sets
+*/
+static inline void loadCounts(const uint8_t *counts, Vec4f &w) {
+    w = to_float(Vec4i(extend_low(extend_low(Vec16uc().load(counts)))));
+}
+
+static inline void loadCounts(const uint8_t *counts, Vec8f &w) {
+    Vec8us c = extend_low(Vec16uc().load(counts));
+    w = Vec8f(to_float(Vec4i(extend_low(c))), to_float(Vec4i(extend_high(c))));
+}
+
+static inline void loadCounts(const uint8_t *counts, Vec2d &w) {
+    w = to_double_low(Vec4i(extend_low(extend_low(Vec16uc().load(counts)))));
+}
+
+static inline void loadCounts(const uint8_t *counts, Vec4d &w) {
+    w = to_double(Vec4i(extend_low(extend_low(Vec16uc().load(counts)))));
+}
+
+#if MAX_VECTOR_SIZE >= 512
+static inline void loadCounts(const uint8_t *counts, Vec16f &w) {
+    Vec16uc c = Vec16uc().load(counts);
+    Vec8us lo = extend_low(c), hi = extend_high(c);
+    w = Vec16f(Vec8f(to_float(Vec4i(extend_low(lo))), to_float(Vec4i(extend_high(lo)))),
+               Vec8f(to_float(Vec4i(extend_low(hi))), to_float(Vec4i(extend_high(hi)))));
+}
+
+static inline void loadCounts(const uint8_t *counts, Vec8d &w) {
+    Vec8us c = extend_low(Vec16uc().load(counts));
+    w = Vec8d(to_double(Vec4i(extend_low(c))), to_double(Vec4i(extend_high(c))));
+}
+#endif
+
 template <class Numeric, class VectorClass>
 Numeric PhyloTree::dotProductSIMD(Numeric *x, Numeric *y, int size) {
     VectorClass res = VectorClass().load_a(x) * VectorClass().load_a(y);
@@ -69,6 +104,83 @@ Numeric PhyloTree::dotProductSIMD(Numeric *x, Numeric *y, int size) {
     return horizontal_add(res);
 }
 
+template <class Numeric, class VectorClass>
+void PhyloTree::dotProductBatchSIMD(Numeric *x, Numeric *y, size_t stride, int nvec, int size, Numeric *res) {
+    int vec = 0;
+    // four rows of y share each load of x
+    for (; vec + 4 <= nvec; vec += 4) {
+        Numeric *y0 = y + vec*stride;
+        Numeric *y1 = y0 + stride;
+        Numeric *y2 = y1 + stride;
+        Numeric *y3 = y2 + stride;
+        VectorClass xi = VectorClass().load_a(x);
+        VectorClass res0 = xi * VectorClass().load_a(y0);
+        VectorClass res1 = xi * VectorClass().load_a(y1);
+        VectorClass res2 = xi * VectorClass().load_a(y2);
+        VectorClass res3 = xi * VectorClass().load_a(y3);
+        for (int i = VectorClass::size(); i < size; i += VectorClass::size()) {
+            xi.load_a(&x[i]);
+            res0 = mul_add(xi, VectorClass().load_a(&y0[i]), res0);
+            res1 = mul_add(xi, VectorClass().load_a(&y1[i]), res1);
+            res2 = mul_add(xi, VectorClass().load_a(&y2[i]), res2);
+            res3 = mul_add(xi, VectorClass().load_a(&y3[i]), res3);
+        }
+        res[vec] = horizontal_add(res0);
+        res[vec+1] = horizontal_add(res1);
+        res[vec+2] = horizontal_add(res2);
+        res[vec+3] = horizontal_add(res3);
+    }
+    for (; vec < nvec; vec++) {
+        res[vec] = dotProductSIMD<Numeric, VectorClass>(x, y + vec*stride, size);
+    }
+}
+
+template <class Numeric, class VectorClass>
+void PhyloTree::dotProductCountBatchSIMD(Numeric *x, uint8_t *y, size_t stride, int nvec, int size, Numeric *res) {
+    int vec = 0;
+    VectorClass w0, w1, w2, w3;
+    for (; vec + 4 <= nvec; vec += 4) {
+        uint8_t *y0 = y + vec*stride;
+        uint8_t *y1 = y0 + stride;
+        uint8_t *y2 = y1 + stride;
+        uint8_t *y3 = y2 + stride;
+        VectorClass xi = VectorClass().load_a(x);
+        loadCounts(y0, w0);
+        loadCounts(y1, w1);
+        loadCounts(y2, w2);
+        loadCounts(y3, w3);
+        VectorClass res0 = xi * w0;
+        VectorClass res1 = xi * w1;
+        VectorClass res2 = xi * w2;
+        VectorClass res3 = xi * w3;
+        for (int i = VectorClass::size(); i < size; i += VectorClass::size()) {
+            xi.load_a(&x[i]);
+            loadCounts(&y0[i], w0);
+            loadCounts(&y1[i], w1);
+            loadCounts(&y2[i], w2);
+            loadCounts(&y3[i], w3);
+            res0 = mul_add(xi, w0, res0);
+            res1 = mul_add(xi, w1, res1);
+            res2 = mul_add(xi, w2, res2);
+            res3 = mul_add(xi, w3, res3);
+        }
+        res[vec] = horizontal_add(res0);
+        res[vec+1] = horizontal_add(res1);
+        res[vec+2] = horizontal_add(res2);
+        res[vec+3] = horizontal_add(res3);
+    }
+    for (; vec < nvec; vec++) {
+        uint8_t *y0 = y + vec*stride;
+        loadCounts(y0, w0);
+        VectorClass res0 = VectorClass().load_a(x) * w0;
+        for (int i = VectorClass::size(); i < size; i += VectorClass::size()) {
+            loadCounts(&y0[i], w0);
+            res0 = mul_add(VectorClass().load_a(&x[i]), w0, res0);
+        }
+        res[vec] = horizontal_add(res0);
+    }
+}
+
 /************************************************************************************************
  *
  *   Highly optimized vectorized versions of likelihood functions
@@ -30,8 +30,12 @@
 void PhyloTree::setDotProductAVX512() {
 #ifdef BOOT_VAL_FLOAT
 		dotProduct = &PhyloTree::dotProductSIMD<float, Vec16f>;
+		dotProductBatch = &PhyloTree::dotProductBatchSIMD<float, Vec16f>;
+		dotProductCountBatch = &PhyloTree::dotProductCountBatchSIMD<float, Vec16f>;
 #else
 		dotProduct = &PhyloTree::dotProductSIMD<double, Vec8d>;
+		dotProductBatch = &PhyloTree::dotProductBatchSIMD<double, Vec8d>;
+		dotProductCountBatch = &PhyloTree::dotProductCountBatchSIMD<double, Vec8d>;
 #endif
         dotProductDouble = &PhyloTree::dotProductSIMD<double, Vec8d>;
 }
@@ -108,6 +112,13 @@ void PhyloTree::setLikelihoodKernelAVX512() {
 
     if (safe_numeric) {
         switch(aln->num_states) {
+        case 2:
+            computeLikelihoodBranchPointer     = &PhyloTree::computeLikelihoodBranchSIMD    <Vec8d, SAFE_LH, 2, true>;
+            computeLikelihoodDervPointer       = &PhyloTree::computeLikelihoodDervSIMD      <Vec8d, SAFE_LH, 2, true>;
+            computeLikelihoodDervMixlenPointer = &PhyloTree::computeLikelihoodDervMixlenSIMD<Vec8d, SAFE_LH, 2, true>;
+            computePartialLikelihoodPointer    = &PhyloTree::computePartialLikelihoodSIMD   <Vec8d, SAFE_LH, 2, true>;
+            computeLikelihoodFromBufferPointer = &PhyloTree::computeLikelihoodFromBufferSIMD<Vec8d, 2, true>;
+            break;
         case 4:
             computeLikelihoodBranchPointer     = &PhyloTree::computeLikelihoodBranchSIMD    <Vec8d, SAFE_LH, 4, true>;
             computeLikelihoodDervPointer       = &PhyloTree::computeLikelihoodDervSIMD      <Vec8d, SAFE_LH, 4, true>;
@@ -122,6 +133,13 @@ void PhyloTree::setLikelihoodKernelAVX512() {
             computePartialLikelihoodPointer    = &PhyloTree::computePartialLikelihoodSIMD   <Vec8d, SAFE_LH, 20, true>;
             computeLikelihoodFromBufferPointer = &PhyloTree::computeLikelihoodFromBufferSIMD<Vec8d, 20, true>;
             break;
+        case 61:
+            computeLikelihoodBranchPointer     = &PhyloTree::computeLikelihoodBranchSIMD    <Vec8d, SAFE_LH, 61, true>;
+            computeLikelihoodDervPointer       = &PhyloTree::computeLikelihoodDervSIMD      <Vec8d, SAFE_LH, 61, true>;
+            computeLikelihoodDervMixlenPointer = &PhyloTree::computeLikelihoodDervMixlenSIMD<Vec8d, SAFE_LH, 61, true>;
+            computePartialLikelihoodPointer    = &PhyloTree::computePartialLikelihoodSIMD   <Vec8d, SAFE_LH, 61, true>;
+            computeLikelihoodFromBufferPointer = &PhyloTree::computeLikelihoodFromBufferSIMD<Vec8d, 61, true>;
+            break;
         default:
             computeLikelihoodBranchPointer     = &PhyloTree::computeLikelihoodBranchGenericSIMD    <Vec8d, SAFE_LH, true>;
             computeLikelihoodDervPointer       = &PhyloTree::computeLikelihoodDervGenericSIMD      <Vec8d, SAFE_LH, true>;
@@ -1153,6 +1153,10 @@ void PhyloTree::computeTraversalInfo(PhyloNode *node, PhyloNode *dad, bool compu
     if ((tip_partial_lh_computed & 1) == 0)
         computeTipPartialLikelihood();
 
+    // partial_lh of the last traversal are now computed
+    if (!lh_cache_pending.empty())
+        saveSubtreeLh();
+
     traversal_info.clear();
 #ifndef KERNEL_FIX_STATES
     size_t nstates = aln->num_states;
@@ -1188,8 +1192,12 @@ void PhyloTree::computeTraversalInfo(PhyloNode *node, PhyloNode *dad, bool compu
 
     PhyloNeighbor *dad_branch = (PhyloNeighbor*)dad->findNeighbor(node);
     PhyloNeighbor *node_branch = (PhyloNeighbor*)node->findNeighbor(dad);
+    // first traversal of a newly read tree: look up shared subtrees in the cache
+    if (lh_cache_armed)
+        prepareSubtreeLhCache(node, dad, VectorClass::size());
     bool dad_locked = computeTraversalInfo(dad_branch, dad, buffer);
     bool node_locked = computeTraversalInfo(node_branch, node, buffer);
+    lh_cache_keys.clear();
     if (params->lh_mem_save == LM_MEM_SAVE) {
         if (dad_locked)
             mem_slots.unlock(dad_branch);
@@ -29,11 +29,15 @@ PhyloSuperTree::PhyloSuperTree()
 {
 	totalNNIs = evalNNIs = 0;
     rescale_codon_brlen = false;
+    nested_part_threads = false;
+    saved_max_active_levels = 1;
 	// Initialize the counter for evaluated NNIs on subtrees. FOR THIS CASE IT WON'T BE initialized.
 }
 
 PhyloSuperTree::PhyloSuperTree(SuperAlignment *alignment, bool new_iqtree, bool create_tree) :  IQTree(alignment) {
     totalNNIs = evalNNIs = 0;
+    nested_part_threads = false;
+    saved_max_active_levels = 1;
 
     rescale_codon_brlen = false;
     bool has_codon = false;
@@ -73,6 +77,8 @@ PhyloSuperTree::PhyloSuperTree(SuperAlignment *alignment, bool new_iqtree, bool
 
 PhyloSuperTree::PhyloSuperTree(SuperAlignment *alignment, PhyloSuperTree *super_tree) :  IQTree(alignment) {
 	totalNNIs = evalNNIs = 0;
+    nested_part_threads = false;
+    saved_max_active_levels = 1;
     rescale_codon_brlen = super_tree->rescale_codon_brlen;
 	part_info = super_tree->part_info;
 	for (vector<Alignment*>::iterator it = alignment->partitions.begin(); it != alignment->partitions.end(); it++) {
@@ -226,10 +232,59 @@ void PhyloSuperTree::changeLikelihoodKernel(LikelihoodKernel lk) {
 	PhyloTree::changeLikelihoodKernel(lk);
 }
 
+/** computation cost of a partition, used to order and to assign threads to the partitions */
+static double computePartitionCost(PhyloTree *part_tree) {
+    Alignment *part_aln = part_tree->aln;
+    return ((double)part_aln->getNSeq())*part_aln->getNPattern()*part_aln->num_states;
+}
+
 void PhyloSuperTree::setNumThreads(int num_threads) {
-    PhyloTree::setNumThreads((size() >= num_threads) ? num_threads : 1);
+    nested_part_threads = false;
+    if (size() < num_threads || num_threads <= 1) {
+        PhyloTree::setNumThreads((size() >= num_threads) ? num_threads : 1);
+        for (iterator it = begin(); it != end(); it++)
+            (*it)->setNumThreads((size() >= num_threads) ? 1 : num_threads);
+        return;
+    }
+    // a partition costing k >= 2 times the share of one thread gets k threads,
+    // running nested inside the loop over partitions; the other partitions
+    // get one thread each and are dynamically scheduled on the remaining threads
+    double total_cost = 0.0;
     for (iterator it = begin(); it != end(); it++)
-        (*it)->setNumThreads((size() >= num_threads) ? 1 : num_threads);
+        total_cost += computePartitionCost(*it);
+    double thread_cost = total_cost / num_threads;
+    int loop_threads = num_threads;
+    for (iterator it = begin(); it != end(); it++) {
+        (*it)->setNumThreads(max(1, (int)(computePartitionCost(*it) / thread_cost)));
+        loop_threads -= (*it)->num_threads - 1;
+    }
+    PhyloTree::setNumThreads(loop_threads);
+#ifdef _OPENMP
+    nested_part_threads = (loop_threads < num_threads);
+#endif
+    if (nested_part_threads && verbose_mode >= VB_MED) {
+        cout << "Threads for large partitions:";
+        for (iterator it = begin(); it != end(); it++)
+            if ((*it)->num_threads > 1)
+                cout << " " << (*it)->aln->name << ":" << (*it)->num_threads;
+        cout << " / others share " << loop_threads << " threads" << endl;
+    }
+}
+
+void PhyloSuperTree::startPartitionLoop() {
+#ifdef _OPENMP
+    if (nested_part_threads) {
+        saved_max_active_levels = omp_get_max_active_levels();
+        omp_set_max_active_levels(max(saved_max_active_levels, omp_get_active_level() + 2));
+    }
+#endif
+}
+
+void PhyloSuperTree::endPartitionLoop() {
+#ifdef _OPENMP
+    if (nested_part_threads)
+        omp_set_max_active_levels(saved_max_active_levels);
+#endif
 }
 
 void PhyloSuperTree::printResultTree(string suffix) {
@@ -670,8 +725,7 @@ void PhyloSuperTree::computePartitionOrder() {
     double *cost = new double[ntrees];
     
     for (i = 0; i < ntrees; i++) {
-        Alignment *part_aln = at(i)->aln;
-        cost[i] = -((double)part_aln->getNSeq())*part_aln->getNPattern()*part_aln->num_states;
+        cost[i] = -computePartitionCost(at(i));
         id[i] = i;
     }
     quicksort(cost, 0, ntrees-1, id);
@@ -721,14 +775,16 @@ double PhyloSuperTree::computeLikelihood(double *pattern_lh, bool save_log_value
 		}
 	} else {
         if (part_order.empty()) computePartitionOrder();
+        startPartitionLoop();
 		#ifdef _OPENMP
-		#pragma omp parallel for reduction(+: tree_lh) schedule(dynamic) if(num_threads > 1)
+		#pragma omp parallel for reduction(+: tree_lh) schedule(dynamic) num_threads(num_threads) if(num_threads > 1)
 		#endif
 		for (int j = 0; j < ntrees; j++) {
             int i = part_order[j];
 			part_info[i].cur_score = at(i)->computeLikelihood();
 			tree_lh += part_info[i].cur_score;
 		}
+        endPartitionLoop();
 	}
 	return tree_lh;
 }
@@ -782,8 +838,9 @@ double PhyloSuperTree::optimizeAllBranches(int my_iterations, double tolerance,
 	double tree_lh = 0.0;
 	int ntrees = size();
     if (part_order.empty()) computePartitionOrder();
+    startPartitionLoop();
 	#ifdef _OPENMP
-	#pragma omp parallel for reduction(+: tree_lh) schedule(dynamic) if(num_threads > 1)
+	#pragma omp parallel for reduction(+: tree_lh) schedule(dynamic) num_threads(num_threads) if(num_threads > 1)
 	#endif
 	for (int j = 0; j < ntrees; j++) {
         int i = part_order[j];
@@ -792,6 +849,7 @@ double PhyloSuperTree::optimizeAllBranches(int my_iterations, double tolerance,
 		if (verbose_mode >= VB_MAX)
 			at(i)->printTree(cout, WT_BR_LEN + WT_NEWLINE);
 	}
+    endPartitionLoop();
 
 	if (my_iterations >= 100) computeBranchLengths();
 	return tree_lh;
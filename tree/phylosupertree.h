@@ -363,6 +363,28 @@ public:
     /* compute part_order vector */
     void computePartitionOrder();
 
+    /**
+        true if large partitions got several threads that run nested inside the loops over partitions
+    */
+    bool nested_part_threads;
+
+    /**
+        enable the nested parallel regions of large partitions before a loop over the partitions
+        with num_threads(num_threads) and schedule(dynamic) along part_order
+    */
+    void startPartitionLoop();
+
+    /**
+        restore the OpenMP nesting level after a loop over the partitions
+    */
+    void endPartitionLoop();
+
+protected:
+    /** max active OpenMP levels before startPartitionLoop() */
+    int saved_max_active_levels;
+
+public:
+
     /**
             get the name of the model
     */
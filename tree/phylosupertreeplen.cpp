@@ -285,8 +285,9 @@ void PhyloSuperTreePlen::optimizeOneBranch(PhyloNode *node1, PhyloNode *node2, b
 
     if (part_order.empty()) computePartitionOrder();
 	// bug fix: assign cur_score into part_info
+    startPartitionLoop();
     #ifdef _OPENMP
-    #pragma omp parallel for private(part) schedule(dynamic) if(num_threads > 1)
+    #pragma omp parallel for private(part) schedule(dynamic) num_threads(num_threads) if(num_threads > 1)
     #endif    
     for (int partid = 0; partid < size(); partid++) {
         part = part_order_by_nptn[partid];
@@ -294,6 +295,7 @@ void PhyloSuperTreePlen::optimizeOneBranch(PhyloNode *node1, PhyloNode *node2, b
             part_info[part].cur_score = at(part)->computeLikelihoodFromBuffer();
         }
     }
+    endPartitionLoop();
 
 	if(clearLH && current_len != current_it->length){
 		for (int part = 0; part < size(); part++) {
@@ -325,8 +327,9 @@ double PhyloSuperTreePlen::computeFunction(double value) {
 	ASSERT(nei1 && nei2);
 
     if (part_order.empty()) computePartitionOrder();
+    startPartitionLoop();
     #ifdef _OPENMP
-    #pragma omp parallel for reduction(+: tree_lh) schedule(dynamic) if(num_threads > 1)
+    #pragma omp parallel for reduction(+: tree_lh) schedule(dynamic) num_threads(num_threads) if(num_threads > 1)
     #endif    
 	for (int partid = 0; partid < ntrees; partid++) {
             int part = part_order_by_nptn[partid];
@@ -345,6 +348,7 @@ double PhyloSuperTreePlen::computeFunction(double value) {
 				tree_lh += part_info[part].cur_score;
 			}
 		}
+    endPartitionLoop();
     return -tree_lh;
 }
 
@@ -383,8 +387,9 @@ void PhyloSuperTreePlen::computeFuncDerv(double value, double &df_ret, double &d
 	ASSERT(nei1 && nei2);
 
     if (part_order.empty()) computePartitionOrder();
+    startPartitionLoop();
     #ifdef _OPENMP
-    #pragma omp parallel for reduction(+: df, ddf) schedule(dynamic) if(num_threads > 1)
+    #pragma omp parallel for reduction(+: df, ddf) schedule(dynamic) num_threads(num_threads) if(num_threads > 1)
     #endif    
 	for (int partid = 0; partid < ntrees; partid++) {
         int part = part_order_by_nptn[partid];
@@ -413,6 +418,7 @@ void PhyloSuperTreePlen::computeFuncDerv(double value, double &df_ret, double &d
             }
         }
     }
+    endPartitionLoop();
     df_ret = -df;
     ddf_ret = -ddf;
 }
@@ -199,6 +199,7 @@ double PhyloSuperTreeUnlinked::treeLengthInternal( double epsilon, Node *node, N
 pair<int, int> PhyloSuperTreeUnlinked::doNNISearch(bool write_info) {
     int NNIs = 0, NNI_steps = 0;
     double score = 0.0;
+    startPartitionLoop();
 #pragma omp parallel for schedule(dynamic) num_threads(num_threads) if (num_threads > 1) reduction(+: NNIs, NNI_steps, score)
     for (int i = 0; i < size(); i++) {
         IQTree *part_tree = (IQTree*)at(part_order[i]);
@@ -217,6 +218,7 @@ pair<int, int> PhyloSuperTreeUnlinked::doNNISearch(bool write_info) {
         delete ckp;
         part_tree->setCheckpoint(getCheckpoint());
     }
+    endPartitionLoop();
 
     setCurScore(score);
     cout << "Log-likelihood: " << score << endl;
@@ -241,6 +243,7 @@ double PhyloSuperTreeUnlinked::doTreeSearch() {
     bool saved_print_ufboot_trees = params->print_ufboot_trees;
     params->print_ufboot_trees = false;
 
+    startPartitionLoop();
 #pragma omp parallel for schedule(dynamic) num_threads(num_threads) if (num_threads > 1) reduction(+: tree_lh)
     for (int i = 0; i < size(); i++) {
         IQTree *part_tree = (IQTree*)at(part_order[i]);
@@ -262,6 +265,7 @@ double PhyloSuperTreeUnlinked::doTreeSearch() {
         delete ckp;
         part_tree->setCheckpoint(getCheckpoint());
     }
+    endPartitionLoop();
 
     verbose_mode = saved_mode;
     params->suppress_output_flags= saved_flag;
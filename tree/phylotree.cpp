@@ -110,6 +110,8 @@ void PhyloTree::init() {
     num_threads = 0;
     num_packets = 0;
     max_lh_slots = 0;
+    lh_cache_armed = false;
+    lh_cache_vector_size = 0;
     save_all_trees = 0;
     nodeBranchDists = nullptr;
     // FOR: upper bounds
@@ -508,6 +510,8 @@ void PhyloTree::setRootNode(const char *my_root, bool multi_taxa) {
 
 void PhyloTree::readTreeString(const string &tree_string) {
     stringstream str(tree_string);
+    // keep the subtrees of the current tree before it is freed
+    saveSubtreeLh();
     freeNode();
     
     // bug fix 2016-04-14: in case taxon name happens to be ID
@@ -527,6 +531,7 @@ void PhyloTree::readTreeString(const string &tree_string) {
         buildNodeSplit();
     }
     current_it = current_it_back = nullptr;
+    lh_cache_armed = true;
 }
 
 void PhyloTree::readTreeStringSeqName(const string &tree_string) {
@@ -1008,7 +1013,9 @@ uint64_t PhyloTree::getMemoryRequired(size_t ncategory, bool full_mem) {
     }
     mem_size += tip_partial_lh_size * sizeof(double);
     // memory for UFBoot
-    if (params->gbo_replicates) {
+    if (params->gbo_replicates && params->ufboot_compact) {
+        mem_size += params->gbo_replicates * get_safe_upper_limit_float(getAlnNPattern()) * sizeof(uint8_t);
+    } else if (params->gbo_replicates) {
 #ifdef BOOT_VAL_FLOAT
         mem_size += params->gbo_replicates * get_safe_upper_limit_float(getAlnNPattern()) * sizeof(BootValType);
 #else
@@ -3826,10 +3833,16 @@ void PhyloTree::computeBioNJ(Params &params) {
     bool wasDoneInMemory = false;
 #ifdef _OPENMP
     // omp_set_nested(true);
-    omp_set_max_active_levels(2);
+    int saved_max_active_levels = omp_get_max_active_levels();
+    omp_set_max_active_levels(max(saved_max_active_levels, 2));
+    // screen output of the tree builder thread, if this thread collects its output
+    string *out_buffer = thread_out_buffer;
+    string builder_log;
     #pragma omp parallel num_threads(2)
     {
         int thread = omp_get_thread_num();
+        if (thread != 0)
+            thread_out_buffer = out_buffer ? &builder_log : nullptr;
 #else
     for (int thread=0; thread<2; ++thread) {
 #endif
@@ -3861,11 +3874,19 @@ void PhyloTree::computeBioNJ(Params &params) {
                 }
             }
         }
+#ifdef _OPENMP
+        if (thread != 0)
+            thread_out_buffer = nullptr;
+#endif
     }
     #ifdef _OPENMP
-        #pragma omp barrier
+        // no orphaned barrier here: inside an enclosing parallel region
+        // (e.g. concurrent bootstrap replicates) it would bind to the outer team
         // omp_set_nested(false);
-        omp_set_max_active_levels(1);
+        // keep nested parallelism of an enclosing parallel region
+        omp_set_max_active_levels(omp_in_parallel() ? saved_max_active_levels : 1);
+        if (out_buffer)
+            out_buffer->append(builder_log);
     #endif
         
     if (!wasDoneInMemory) {
@@ -6041,6 +6062,10 @@ bool PhyloTree::computeTraversalInfo(PhyloNeighbor *dad_branch, PhyloNode *dad,
         return mem_slots.lock(dad_branch);
     }
 
+    if (!lh_cache_keys.empty() && restoreSubtreeLh(dad_branch, dad)) {
+        return mem_slots.lock(dad_branch);
+    }
+
     size_t num_leaves = 0;
     bool locked[node->degree()];
     memset(locked, 0, node->degree());
@@ -6142,6 +6167,140 @@ bool PhyloTree::computeTraversalInfo(PhyloNeighbor *dad_branch, PhyloNode *dad,
     return mem_slots.lock(dad_branch);
 }
 
+/****************************************************************************
+        subtree likelihood cache across trees
+ ****************************************************************************/
+
+bool PhyloTree::isSubtreeLhCacheEnabled() {
+    if (getSubtreeLhCacheSlots() == 0 || !model || !site_rate)
+        return false;
+    if (isSuperTree() || isMixlen() || isTreeMix() || params->pll)
+        return false;
+    return model->useRevKernel() && !model->isSiteSpecificModel();
+}
+
+size_t PhyloTree::getSubtreeLhCacheSlots() {
+    if (!params || params->lh_mem_save != LM_PER_NODE || params->lh_cache_size <= 0.0 || max_lh_slots <= 0)
+        return 0;
+    return (size_t)(params->lh_cache_size * max_lh_slots);
+}
+
+uint64_t PhyloTree::getSubtreeLhCacheMemory() {
+    if (!model || !site_rate || !model_factory)
+        return 0;
+    return getSubtreeLhCacheSlots() * (getPartialLhBytes() + getScaleNumBytes());
+}
+
+/** mix an array of doubles into hash value h */
+static uint64_t mixHashDoubles(uint64_t h, const double *values, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        uint64_t bits;
+        memcpy(&bits, &values[i], sizeof(bits));
+        h = mixHash64(h ^ bits);
+    }
+    return h;
+}
+
+uint64_t PhyloTree::getSubtreeLhModelVersion(int vector_size) {
+    size_t nstates = aln->num_states;
+    size_t nmix = model->getNMixtures();
+    uint64_t h = mixHash64((uint64_t)(uintptr_t)aln);
+    h = mixHash64(h ^ aln->size());
+    h = mixHash64(h ^ model_factory->unobserved_ptns.size());
+    h = mixHash64(h ^ ((uint64_t)vector_size << 1) ^ (uint64_t)safe_numeric);
+    h = mixHash64(h ^ (uint64_t)model_factory->fused_mix_rate);
+    h = mixHashDoubles(h, model->getEigenvalues(), nstates*nmix);
+    h = mixHashDoubles(h, model->getEigenvectors(), nstates*nstates*nmix);
+    h = mixHashDoubles(h, model->getInverseEigenvectors(), nstates*nstates*nmix);
+    for (int c = 0; c < site_rate->getNRate(); c++) {
+        double rate = site_rate->getRate(c);
+        h = mixHashDoubles(h, &rate, 1);
+    }
+    return h;
+}
+
+SubtreeLhKey PhyloTree::computeSubtreeLhKey(PhyloNeighbor *dad_branch, PhyloNode *dad, uint64_t model_version,
+                                            unordered_map<PhyloNeighbor*, SubtreeLhKey> &keys)
+{
+    PhyloNode *node = (PhyloNode*)dad_branch->node;
+    SubtreeLhKey key;
+    key.model = model_version;
+    if (node->isLeaf()) {
+        key.clade = key.topology = mixHash64(node->id + 1);
+        return key;
+    }
+    auto found = keys.find(dad_branch);
+    if (found != keys.end())
+        return found->second;
+    // partial_lh does not depend on the order of children, so combine them commutatively
+    key.clade = 0;
+    uint64_t children = 0;
+    FOR_NEIGHBOR_IT(node, dad, it) {
+        SubtreeLhKey child = computeSubtreeLhKey((PhyloNeighbor*)(*it), node, model_version, keys);
+        uint64_t len_bits;
+        memcpy(&len_bits, &(*it)->length, sizeof(len_bits));
+        key.clade += child.clade;
+        children += mixHash64(child.topology ^ mixHash64(len_bits));
+    }
+    key.topology = mixHash64(children);
+    keys[dad_branch] = key;
+    return key;
+}
+
+void PhyloTree::prepareSubtreeLhCache(PhyloNode *node, PhyloNode *dad, int vector_size) {
+    lh_cache_armed = false;
+    if (!isSubtreeLhCacheEnabled())
+        return;
+    lh_cache.init(getSubtreeLhCacheSlots(), getPartialLhSize(), getScaleNumSize());
+    lh_cache_vector_size = vector_size;
+    uint64_t model_version = getSubtreeLhModelVersion(vector_size);
+    computeSubtreeLhKey((PhyloNeighbor*)dad->findNeighbor(node), dad, model_version, lh_cache_keys);
+    computeSubtreeLhKey((PhyloNeighbor*)node->findNeighbor(dad), node, model_version, lh_cache_keys);
+}
+
+bool PhyloTree::restoreSubtreeLh(PhyloNeighbor *dad_branch, PhyloNode *dad) {
+    auto key = lh_cache_keys.find(dad_branch);
+    if (key == lh_cache_keys.end())
+        return false;
+    reorientPartialLh(dad_branch, dad);
+    if (lh_cache.lookup(key->second, dad_branch->partial_lh, dad_branch->scale_num)) {
+        dad_branch->partial_lh_computed |= 1;
+        return true;
+    }
+    lh_cache_pending.push_back(make_pair(TraversalInfo(dad_branch, dad), key->second));
+    return false;
+}
+
+void PhyloTree::saveSubtreeLh() {
+    if (lh_cache_pending.empty())
+        return;
+    if (!root || !isSubtreeLhCacheEnabled()) {
+        lh_cache_pending.clear();
+        return;
+    }
+    // the tree may have changed since the traversal, so only keep branches still in the tree
+    unordered_map<PhyloNeighbor*, PhyloNode*> branch_dad;
+    NodeVector nodes;
+    getAllNodesInSubtree(root->isLeaf() ? root->neighbors[0]->node : root, nullptr, nodes);
+    for (auto node : nodes)
+        FOR_NEIGHBOR_IT(node, nullptr, it)
+            branch_dad[(PhyloNeighbor*)(*it)] = (PhyloNode*)node;
+    uint64_t model_version = getSubtreeLhModelVersion(lh_cache_vector_size);
+    unordered_map<PhyloNeighbor*, SubtreeLhKey> keys;
+    for (auto pending : lh_cache_pending) {
+        PhyloNeighbor *dad_branch = pending.first.dad_branch;
+        PhyloNode *dad = pending.first.dad;
+        auto it = branch_dad.find(dad_branch);
+        if (it == branch_dad.end() || it->second != dad)
+            continue;
+        if ((dad_branch->partial_lh_computed & 1) == 0 || !dad_branch->partial_lh || pending.second.model != model_version)
+            continue;
+        if (computeSubtreeLhKey(dad_branch, dad, model_version, keys) == pending.second)
+            lh_cache.insert(pending.second, dad_branch->partial_lh, dad_branch->scale_num);
+    }
+    lh_cache_pending.clear();
+}
+
 void PhyloTree::writeSiteLh(ostream &out, SiteLoglType wsl, int partid) {
     // error checking
     if (isTreeMix()) {
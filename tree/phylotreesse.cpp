@@ -117,6 +117,7 @@ void PhyloTree::setLikelihoodKernel(LikelihoodKernel lk) {
 //		dotProduct = &PhyloTree::dotProductSIMD<float, Vec1f>;
 #else
 		dotProduct = &PhyloTree::dotProductSIMD<double, Vec1d>;
+		dotProductBatch = &PhyloTree::dotProductBatchSIMD<double, Vec1d>;
 #endif
         dotProductDouble = &PhyloTree::dotProductSIMD<double, Vec1d>;
 #endif
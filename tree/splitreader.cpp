@@ -0,0 +1,421 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "splitreader.h"
+#include "mtreeset.h"
+#include <zlib.h>
+
+/** number of bytes read from the tree file at once */
+const int TREE_BLOCK_SIZE = 1 << 20;
+
+/** number of trees parsed in parallel at once, bounding the memory of the splits */
+const size_t TREE_BATCH_SIZE = 1024;
+
+/** maximal length of a name or branch length, as in MTree::parseFile() */
+const size_t MAX_TOKEN_LEN = 1000;
+
+/**
+    compact topology of a Newick tree, nodes are numbered in the order they are parsed.
+    The children of a node are kept in input order, which together with the parent
+    gives the neighbor order of the Node built by MTree::readTree().
+*/
+struct NewickTopology {
+    IntVector parent;       // parent node, -1 for the top node
+    IntVector first_child;  // -1 for leaves
+    IntVector last_child;
+    IntVector next_sibling;
+    IntVector num_child;
+    DoubleVector length;    // length of the branch to the parent, -1 if absent
+    IntVector leaves;       // leaf nodes in input order
+    StrVector leaf_names;
+    double top_length;      // length after the top node, -1 if absent
+    bool has_top_length;
+    int root_leaf;          // leaf where MTree::convertSplits() starts
+
+    int addNode(int dad, double len = -1.0);
+    bool parse(const string &str);
+    bool setRoot(bool &is_rooted);
+    bool convertSplits(StrVector &taxname, vector<Split*> &splits);
+};
+
+int NewickTopology::addNode(int dad, double len) {
+    int node = parent.size();
+    parent.push_back(dad);
+    first_child.push_back(-1);
+    last_child.push_back(-1);
+    next_sibling.push_back(-1);
+    num_child.push_back(0);
+    length.push_back(len);
+    if (dad >= 0) {
+        if (last_child[dad] >= 0)
+            next_sibling[last_child[dad]] = node;
+        else
+            first_child[dad] = node;
+        last_child[dad] = node;
+        num_child[dad]++;
+    }
+    return node;
+}
+
+inline void skipSpaces(const string &str, size_t &pos) {
+    while (pos < str.length() && controlchar(str[pos]))
+        pos++;
+}
+
+/** skip a name or branch length, @return its length */
+inline size_t skipToken(const string &str, size_t &pos) {
+    size_t start = pos;
+    while (pos < str.length() && !is_newick_token(str[pos]) && !controlchar(str[pos]))
+        pos++;
+    return pos - start;
+}
+
+/**
+    parse an optional ":length" and the spaces after it
+    @return false if the length is not a plain number
+*/
+static bool parseBranchLength(const string &str, size_t &pos, double &len, bool &has_len) {
+    len = -1.0;
+    has_len = false;
+    if (pos >= str.length() || str[pos] != ':')
+        return true;
+    pos++;
+    skipSpaces(str, pos);
+    size_t start = pos;
+    size_t token_len = skipToken(str, pos);
+    if (token_len == 0 || token_len >= MAX_TOKEN_LEN)
+        return false;
+    // same checks as is_number() and convert_double(), distributions are not supported
+    const char *begin = str.c_str() + start;
+    char *endptr;
+    len = strtod(begin, &endptr);
+    if (endptr != begin + token_len || len == HUGE_VAL || fabs(len) == HUGE_VALF)
+        return false;
+    skipSpaces(str, pos);
+    has_len = true;
+    return true;
+}
+
+bool NewickTopology::parse(const string &str) {
+    // comments, quoted names and multiple branch lengths need the full MTree parser
+    if (str.find_first_of("[]'\"") != string::npos)
+        return false;
+    size_t pos = 0;
+    skipSpaces(str, pos);
+    if (pos >= str.length() || str[pos] != '(')
+        return false;
+    pos++;
+    int node = addNode(-1);
+    double len;
+    bool has_len;
+    while (true) {
+        // parse the next child of node
+        skipSpaces(str, pos);
+        if (pos >= str.length())
+            return false;
+        if (str[pos] == '(') {
+            node = addNode(node);
+            pos++;
+            continue;
+        }
+        size_t start = pos;
+        size_t name_len = skipToken(str, pos);
+        if (name_len == 0 || name_len >= MAX_TOKEN_LEN)
+            return false;
+        string name = str.substr(start, name_len);
+        if (name.find('/') != string::npos)
+            return false;
+        renameString(name);
+        skipSpaces(str, pos);
+        if (!parseBranchLength(str, pos, len, has_len))
+            return false;
+        leaves.push_back(addNode(node, len));
+        leaf_names.push_back(name);
+        // close the finished internal nodes
+        while (true) {
+            if (pos >= str.length())
+                return false;
+            if (str[pos] == ',') {
+                pos++;
+                break;
+            }
+            if (str[pos] != ')')
+                return false;
+            pos++;
+            // skip the internal node name, e.g. support values
+            skipSpaces(str, pos);
+            if (skipToken(str, pos) >= MAX_TOKEN_LEN)
+                return false;
+            skipSpaces(str, pos);
+            if (pos < str.length() && str[pos] == '/')
+                return false;
+            if (!parseBranchLength(str, pos, len, has_len))
+                return false;
+            if (parent[node] < 0) {
+                top_length = len;
+                has_top_length = has_len;
+                return pos+1 == str.length() && str[pos] == ';';
+            }
+            length[node] = len;
+            node = parent[node];
+        }
+    }
+}
+
+bool NewickTopology::setRoot(bool &is_rooted) {
+    if (leaves.empty() || num_child[0] < 2)
+        return false;
+    // same rule as MTree::readTree()
+    if (is_rooted || (has_top_length && top_length != 0.0) || num_child[0] == 2) {
+        if (top_length == -1.0)
+            top_length = 0.0;
+        if (top_length < 0.0)
+            return false;
+        is_rooted = true;
+        root_leaf = addNode(0, top_length);
+        leaves.push_back(root_leaf);
+        leaf_names.push_back(ROOT_NAME);
+        return true;
+    }
+    root_leaf = leaves[0];
+    for (int child = first_child[0]; child >= 0; child = next_sibling[child])
+        if (first_child[child] < 0) {
+            root_leaf = child;
+            break;
+        }
+    return true;
+}
+
+bool NewickTopology::convertSplits(StrVector &taxname, vector<Split*> &splits) {
+    int ntaxa = taxname.size();
+    if (leaves.size() != (size_t)ntaxa)
+        return false;
+    // taxon IDs are ranks of the names, like MTreeSet::checkConsistency()
+    IntVector taxon(parent.size(), -1);
+    vector<bool> seen(ntaxa, false);
+    for (size_t i = 0; i < leaves.size(); i++) {
+        StrVector::iterator it = lower_bound(taxname.begin(), taxname.end(), leaf_names[i]);
+        if (it == taxname.end() || *it != leaf_names[i])
+            return false;
+        int id = it - taxname.begin();
+        if (seen[id])
+            return false;
+        seen[id] = true;
+        taxon[leaves[i]] = id;
+    }
+
+    // non-recursive version of MTree::convertSplits() starting from the root leaf
+    struct Frame {
+        int node, dad;
+        int next_child;
+        bool parent_done, has_child;
+        Split *sp;
+    };
+    Split root_split(ntaxa);
+    vector<Frame> stack;
+    stack.push_back({root_leaf, -1, first_child[root_leaf], false, false, &root_split});
+    while (true) {
+        Frame &frame = stack.back();
+        int next = -1;
+        double len = -1.0;
+        if (frame.next_child >= 0 && frame.next_child == frame.dad)
+            frame.next_child = next_sibling[frame.next_child];
+        if (frame.next_child >= 0) {
+            next = frame.next_child;
+            len = length[next];
+            frame.next_child = next_sibling[next];
+        } else if (!frame.parent_done) {
+            frame.parent_done = true;
+            if (parent[frame.node] >= 0 && parent[frame.node] != frame.dad) {
+                next = parent[frame.node];
+                len = length[frame.node];
+            }
+        }
+        if (next >= 0) {
+            frame.has_child = true;
+            int node = frame.node;
+            stack.push_back({next, node, first_child[next], false, false, new Split(ntaxa, len)});
+            continue;
+        }
+        Frame done = frame;
+        stack.pop_back();
+        if (!done.has_child)
+            done.sp->addTaxon(taxon[done.node]);
+        if (stack.empty())
+            break;
+        int node = stack.back().node;
+        *stack.back().sp += *done.sp;
+        // orient as in MTreeSet::convertSplitIDs()
+        if (!done.sp->containTaxon(0))
+            done.sp->invert();
+        // ignore nodes with degree of 2 because such split will be added before
+        if (num_child[node] + (parent[node] >= 0) != 2)
+            splits.push_back(done.sp);
+        else
+            delete done.sp;
+    }
+    return true;
+}
+
+SplitReader::SplitReader() {
+}
+
+bool SplitReader::convertTrees(StrVector &trees, bool is_rooted, double weight_threshold, int &num_rooted) {
+    size_t ntree = trees.size();
+    if (taxname.empty()) {
+        // the first tree defines the taxon set
+        NewickTopology tree;
+        bool tree_rooted = is_rooted;
+        if (!tree.parse(trees[0]) || !tree.setRoot(tree_rooted))
+            return false;
+        taxname = tree.leaf_names;
+        sort(taxname.begin(), taxname.end());
+        if (adjacent_find(taxname.begin(), taxname.end()) != taxname.end())
+            return false;
+    }
+
+    vector<vector<Split*> > splits(ntree);
+    vector<char> ok(ntree), rooted(ntree);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (size_t id = 0; id < ntree; id++) {
+        NewickTopology tree;
+        bool tree_rooted = is_rooted;
+        ok[id] = tree.parse(trees[id]) && tree.setRoot(tree_rooted) && tree.convertSplits(taxname, splits[id]);
+        rooted[id] = tree_rooted;
+    }
+    if (find(ok.begin(), ok.end(), 0) != ok.end()) {
+        for (size_t id = 0; id < ntree; id++)
+            for (Split *sp : splits[id])
+                delete sp;
+        return false;
+    }
+
+    // each distinct split is stored once and identified by its index
+    size_t first = tree_splits.size();
+    tree_splits.resize(first + ntree);
+    num_trivial.resize(first + ntree, 0);
+    for (size_t id = 0; id < ntree; id++) {
+        IntVector &ids = tree_splits[first + id];
+        ids.reserve(splits[id].size());
+        for (Split *sp : splits[id]) {
+            bool heavy = sp->getWeight() >= weight_threshold;
+            if (sp->trivial() >= 0)
+                num_trivial[first + id]++;
+            int split_id;
+            if (split_ids.findSplit(sp, split_id)) {
+                delete sp;
+            } else {
+                split_id = split_table.size();
+                split_table.push_back(sp);
+                split_ids.insertSplit(sp, split_id);
+            }
+            ids.push_back(split_id*2 + heavy);
+        }
+        sort(ids.begin(), ids.end());
+        num_rooted += rooted[id];
+    }
+    return true;
+}
+
+bool SplitReader::readTrees(const char *infile, bool is_rooted, int burnin, int max_count,
+    double weight_threshold)
+{
+    cout << "Reading tree(s) file " << infile << " ..." << endl;
+    gzFile file = gzopen(infile, "rb");
+    if (!file)
+        outError(ERR_READ_INPUT, infile);
+    vector<char> buffer(TREE_BLOCK_SIZE);
+    StrVector batch;
+    string tree_str;
+    int discarded = 0, count = 0, num_rooted = 0;
+    size_t first = tree_splits.size();
+    bool ok = true;
+    int num;
+    while (ok && count < max_count && (num = gzread(file, buffer.data(), TREE_BLOCK_SIZE)) > 0) {
+        char *pos = buffer.data(), *end = pos + num;
+        while (pos < end && count < max_count) {
+            char *semicolon = (char*)memchr(pos, ';', end - pos);
+            if (discarded < burnin) {
+                if (!semicolon)
+                    break;
+                pos = semicolon + 1;
+                if (++discarded == burnin)
+                    cout << discarded << " beginning tree(s) discarded" << endl;
+                continue;
+            }
+            if (!semicolon) {
+                tree_str.append(pos, end);
+                break;
+            }
+            tree_str.append(pos, semicolon + 1);
+            pos = semicolon + 1;
+            batch.push_back(tree_str);
+            tree_str.clear();
+            count++;
+            if (batch.size() == TREE_BATCH_SIZE) {
+                ok = convertTrees(batch, is_rooted, weight_threshold, num_rooted);
+                batch.clear();
+                if (!ok)
+                    break;
+            }
+        }
+    }
+    gzclose(file);
+    if (discarded < burnin) {
+        cout << discarded << " beginning tree(s) discarded" << endl;
+        outError("Burnin value is too large.");
+    }
+    if (ok && !batch.empty())
+        ok = convertTrees(batch, is_rooted, weight_threshold, num_rooted);
+    // a trailing tree without ';' is an error left to MTree::readTree()
+    if (count < max_count && tree_str.find_first_not_of(" \t\r\n") != string::npos)
+        ok = false;
+    if (!ok || count == 0)
+        return false;
+    int ntree = tree_splits.size() - first;
+    cout << ntree << " tree(s) loaded (" << num_rooted << " rooted and " << ntree - num_rooted << " unrooted)" << endl;
+    return true;
+}
+
+void SplitReader::convertSplits(SplitGraph &sg, double split_threshold, double weight_threshold) {
+    IntVector split_count(split_table.size(), 0);
+    for (IntVector &ids : tree_splits)
+        for (int id : ids)
+            split_count[id >> 1]++;
+
+    sg.createBlocks();
+    for (string &name : taxname)
+        sg.getTaxa()->AddTaxonLabel(NxsString(name.c_str()));
+    // splits are numbered by first occurrence, the order of MTreeSet::convertSplits()
+    SplitIntMap hash_ss;
+    for (size_t id = 0; id < split_table.size(); id++) {
+        Split *sp = new Split(*split_table[id]);
+        if (sp->shouldInvert())
+            sp->invert();
+        sp->setWeight(split_count[id]);
+        sg.push_back(sp);
+        hash_ss.insertSplit(sp, split_count[id]);
+    }
+    MTreeSet::discardLightSplits(sg, weight_threshold);
+    MTreeSet::discardRareSplits(sg, hash_ss, split_threshold, tree_splits.size());
+}
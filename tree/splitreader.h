@@ -0,0 +1,94 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef SPLITREADER_H
+#define SPLITREADER_H
+
+#include "pda/splitgraph.h"
+#include "pda/hashsplitset.h"
+
+/**
+    Reader that converts a (gzipped) file of Newick trees directly into split IDs,
+    without building the MTree node graphs. The file is read in blocks and the trees
+    of a block are parsed in parallel. Splits are identified and oriented as in
+    MTreeSet::convertSplitIDs(), so the result can be passed to MTreeSet::computeRFDist().
+
+    Only plain Newick trees on the same taxon set are supported. For anything else
+    (comments, quoted names, multiple branch lengths, ...) readTrees() returns false
+    and the caller should fall back to MTreeSet.
+*/
+class SplitReader {
+public:
+
+    SplitReader();
+
+    /**
+        read trees from a file and append their split IDs to tree_splits;
+        can be called again to append a second tree set on the same taxa
+        @param infile input file name, possibly gzipped
+        @param is_rooted true to treat all trees as rooted
+        @param burnin number of beginning trees to discard
+        @param max_count maximum number of trees to read
+        @param weight_threshold splits with weight (branch length) below this are marked light
+        @return false if the file must be read by MTreeSet instead, the reader is then unusable
+    */
+    bool readTrees(const char *infile, bool is_rooted, int burnin, int max_count,
+        double weight_threshold = -1000);
+
+    /**
+        convert all trees read into a split system weighted by the number of trees
+        containing each split, like MTreeSet::convertSplits() with SW_COUNT
+        @param sg (OUT) split system
+        @param split_threshold only keep splits present in more than this fraction of trees
+        @param weight_threshold only keep splits with weight above this
+    */
+    void convertSplits(SplitGraph &sg, double split_threshold, double weight_threshold);
+
+    /** sorted taxon names, taxon IDs are indices into this vector */
+    StrVector taxname;
+
+    /** distinct splits, containing taxon 0, indexed by split ID */
+    SplitGraph split_table;
+
+    /** map from split to split ID */
+    SplitIntMap split_ids;
+
+    /** sorted split IDs per tree, each as split_id*2 + heavy, see MTreeSet::convertSplitIDs() */
+    vector<IntVector> tree_splits;
+
+    /** number of trivial splits per tree */
+    IntVector num_trivial;
+
+protected:
+
+    /**
+        convert a batch of Newick strings into split IDs
+        @param trees Newick strings, each ended by ';'
+        @param is_rooted true to treat all trees as rooted
+        @param weight_threshold splits with weight below this are marked light
+        @param num_rooted (IN/OUT) number of rooted trees
+        @return false if some tree is not supported
+    */
+    bool convertTrees(StrVector &trees, bool is_rooted, double weight_threshold, int &num_rooted);
+
+};
+
+#endif
@@ -0,0 +1,97 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "tree/phylotree.h"
+#include "subtreelhcache.h"
+
+SubtreeLhCache::SubtreeLhCache() {
+    num_hits = 0;
+    num_misses = 0;
+    max_entries = 0;
+    lh_size = 0;
+    scale_size = 0;
+}
+
+SubtreeLhCache::~SubtreeLhCache() {
+    clear();
+}
+
+void SubtreeLhCache::init(size_t max_entries, size_t lh_size, size_t scale_size) {
+    if (lh_size != this->lh_size || scale_size != this->scale_size)
+        clear();
+    this->max_entries = max_entries;
+    this->lh_size = lh_size;
+    this->scale_size = scale_size;
+    while (entries.size() > max_entries) {
+        entry_map.erase(entries.back().key);
+        aligned_free(entries.back().partial_lh);
+        aligned_free(entries.back().scale_num);
+        entries.pop_back();
+    }
+}
+
+void SubtreeLhCache::clear() {
+    for (auto it = entries.begin(); it != entries.end(); it++) {
+        aligned_free(it->partial_lh);
+        aligned_free(it->scale_num);
+    }
+    entries.clear();
+    entry_map.clear();
+}
+
+bool SubtreeLhCache::lookup(const SubtreeLhKey &key, double *partial_lh, UBYTE *scale_num) {
+    auto it = entry_map.find(key);
+    if (it == entry_map.end()) {
+        num_misses++;
+        return false;
+    }
+    num_hits++;
+    // move to the front as the most recently used entry
+    entries.splice(entries.begin(), entries, it->second);
+    memcpy(partial_lh, it->second->partial_lh, lh_size*sizeof(double));
+    memcpy(scale_num, it->second->scale_num, scale_size*sizeof(UBYTE));
+    return true;
+}
+
+void SubtreeLhCache::insert(const SubtreeLhKey &key, const double *partial_lh, const UBYTE *scale_num) {
+    if (max_entries == 0)
+        return;
+    auto it = entry_map.find(key);
+    if (it != entry_map.end()) {
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+    Entry entry;
+    if (entries.size() >= max_entries) {
+        // reuse the memory of the least recently used entry
+        entry = entries.back();
+        entry_map.erase(entry.key);
+        entries.pop_back();
+    } else {
+        entry.partial_lh = aligned_alloc<double>(lh_size);
+        entry.scale_num = aligned_alloc<UBYTE>(scale_size);
+    }
+    entry.key = key;
+    memcpy(entry.partial_lh, partial_lh, lh_size*sizeof(double));
+    memcpy(entry.scale_num, scale_num, scale_size*sizeof(UBYTE));
+    entries.push_front(entry);
+    entry_map[key] = entries.begin();
+}
@@ -0,0 +1,119 @@
+/***************************************************************************
+ *   Copyright (C) 2009-2016 by                                            *
+ *   BUI Quang Minh <minh.bui@univie.ac.at>                                *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef SUBTREELHCACHE_H
+#define SUBTREELHCACHE_H
+
+#ifndef PHYLOTREE_H
+#error "Please #include phylotree.h before including this header file"
+#endif
+
+#include <list>
+
+/**
+    key of a subtree partial likelihood vector:
+    the clade below the branch, its topology and branch lengths, and the model version
+*/
+struct SubtreeLhKey {
+    uint64_t clade; // order-independent hash of the taxon set below the branch
+    uint64_t topology; // hash of the subtree topology and its branch lengths
+    uint64_t model; // version of the model parameters
+
+    bool operator==(const SubtreeLhKey &other) const {
+        return clade == other.clade && topology == other.topology && model == other.model;
+    }
+};
+
+struct SubtreeLhKeyHash {
+    size_t operator()(const SubtreeLhKey &key) const {
+        return (size_t)(key.clade ^ (key.topology * 0x9E3779B97F4A7C15ULL) ^ (key.model << 1));
+    }
+};
+
+/** mix 64 bits into a well-distributed hash value */
+inline uint64_t mixHash64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+    bounded LRU cache of partial likelihood vectors of subtrees,
+    used to avoid recomputing shared clades when a new tree is read in
+*/
+class SubtreeLhCache {
+public:
+
+    SubtreeLhCache();
+
+    ~SubtreeLhCache();
+
+    /**
+        set the maximal number of vectors and the vector sizes,
+        clear the cache if the sizes changed
+        @param max_entries maximal number of cached vectors
+        @param lh_size number of partial_lh entries per vector
+        @param scale_size number of scale_num entries per vector
+    */
+    void init(size_t max_entries, size_t lh_size, size_t scale_size);
+
+    /** remove all vectors and release the memory */
+    void clear();
+
+    /**
+        copy the cached vectors of a subtree if found
+        @return TRUE if found, FALSE otherwise
+    */
+    bool lookup(const SubtreeLhKey &key, double *partial_lh, UBYTE *scale_num);
+
+    /** insert a copy of the vectors of a subtree, evicting the least recently used one if full */
+    void insert(const SubtreeLhKey &key, const double *partial_lh, const UBYTE *scale_num);
+
+    /** @return TRUE if the cache can hold at least one vector */
+    bool isEnabled() { return max_entries > 0; }
+
+    /** number of successful lookups */
+    size_t num_hits;
+
+    /** number of failed lookups */
+    size_t num_misses;
+
+protected:
+
+    struct Entry {
+        SubtreeLhKey key;
+        double *partial_lh;
+        UBYTE *scale_num;
+    };
+
+    /** entries in the order of most to least recently used */
+    list<Entry> entries;
+
+    /** mapping from key to entry for fast lookup */
+    unordered_map<SubtreeLhKey, list<Entry>::iterator, SubtreeLhKeyHash> entry_map;
+
+    size_t max_entries;
+    size_t lh_size;
+    size_t scale_size;
+};
+
+#endif // SUBTREELHCACHE_H
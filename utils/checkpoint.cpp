@@ -10,10 +10,195 @@
 #include "timeutil.h"
 #include "gzstream.h"
 #include <cstdio>
+#include <sys/stat.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 
 const char* CKP_HEADER =     "--- # IQ-TREE Checkpoint ver >= 1.6";
 const char* CKP_HEADER_OLD = "--- # IQ-TREE Checkpoint";
 
+/** first and last line of a record of entries appended to the checkpoint file */
+const char* CKP_RECORD_BEGIN = "--- # record";
+const char* CKP_RECORD_END =   "...";
+
+/** rewrite the whole checkpoint file after this many appended records */
+const int CKP_MAX_RECORDS = 20;
+
+static size_t getFileSize(const string &filename) {
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0)
+        return 0;
+    return st.st_size;
+}
+
+/**
+    background thread writing checkpoint snapshots to file, such that
+    the tree search is not blocked by compression and disk I/O
+*/
+class CheckpointWriter {
+public:
+
+    CheckpointWriter() {
+        busy = false;
+        stop = false;
+        bytes_written = 0;
+        write_time = 0.0;
+        max_write_time = 0.0;
+        num_writes = 0;
+        worker = std::thread(&CheckpointWriter::run, this);
+    }
+
+    /** write all pending snapshots and stop the thread */
+    ~CheckpointWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        cond.notify_all();
+        worker.join();
+    }
+
+    /**
+        queue a snapshot for writing.
+        A full snapshot supersedes all pending snapshots, a record is merged
+        into the last pending snapshot if it has not been started yet
+        @param filename checkpoint file name
+        @param compression true to write gzip-compressed file
+        @param full true to rewrite the file, false to append a record
+        @param data serialized snapshot, moved into the queue
+    */
+    void submit(const string &filename, bool compression, bool full, string &data) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (full)
+                jobs.clear();
+            if (!full && !jobs.empty() && jobs.back().filename == filename &&
+                jobs.back().compression == compression) {
+                jobs.back().data += data;
+            } else {
+                jobs.push_back(Job());
+                jobs.back().filename = filename;
+                jobs.back().compression = compression;
+                jobs.back().full = full;
+                jobs.back().data.swap(data);
+            }
+        }
+        cond.notify_all();
+    }
+
+    /** wait until all queued snapshots are written */
+    void wait() {
+        std::unique_lock<std::mutex> lock(mtx);
+        cond.wait(lock, [this]{ return jobs.empty() && !busy; });
+    }
+
+    /** number of bytes written to disk */
+    size_t bytes_written;
+
+    /** total and maximum time in seconds for writing one snapshot */
+    double write_time, max_write_time;
+
+    /** number of snapshots written */
+    int num_writes;
+
+private:
+
+    struct Job {
+        string filename;
+        bool compression;
+        bool full;
+        string data;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            cond.wait(lock, [this]{ return stop || !jobs.empty(); });
+            if (jobs.empty())
+                break;
+            Job job;
+            job.filename.swap(jobs.front().filename);
+            job.data.swap(jobs.front().data);
+            job.compression = jobs.front().compression;
+            job.full = jobs.front().full;
+            jobs.pop_front();
+            busy = true;
+            lock.unlock();
+            double start_time = getRealTime();
+            size_t bytes = job.full ? writeFull(job) : appendRecord(job);
+            double elapsed = getRealTime() - start_time;
+            lock.lock();
+            busy = false;
+            bytes_written += bytes;
+            write_time += elapsed;
+            max_write_time = max(max_write_time, elapsed);
+            num_writes++;
+            cond.notify_all();
+        }
+    }
+
+    /** write a full snapshot into a temporary file and rename it */
+    size_t writeFull(Job &job) {
+        string filename_tmp = job.filename + ".tmp";
+        try {
+            ostream *out;
+            if (job.compression)
+                out = new ogzstream(filename_tmp.c_str());
+            else
+                out = new ofstream(filename_tmp.c_str());
+            out->exceptions(ios::failbit | ios::badbit);
+            out->write(job.data.c_str(), job.data.length());
+            if (job.compression)
+                ((ogzstream*)out)->close();
+            else
+                ((ofstream*)out)->close();
+            delete out;
+            if (fileExists(job.filename)) {
+                if (std::remove(job.filename.c_str()) != 0)
+                    outError("Cannot remove file ", job.filename);
+            }
+            if (std::rename(filename_tmp.c_str(), job.filename.c_str()) != 0)
+                outError("Cannot rename file ", filename_tmp);
+        } catch (ios::failure &) {
+            outError(ERR_WRITE_OUTPUT, job.filename.c_str());
+        }
+        return getFileSize(job.filename);
+    }
+
+    /** append a record to the checkpoint file, as a new gzip member if compressed */
+    size_t appendRecord(Job &job) {
+        size_t old_size = getFileSize(job.filename);
+        if (job.compression) {
+            gzFile file = gzopen(job.filename.c_str(), "ab");
+            if (!file)
+                outError(ERR_WRITE_OUTPUT, job.filename.c_str());
+            if (gzwrite(file, job.data.c_str(), job.data.length()) != (int)job.data.length() ||
+                gzclose(file) != Z_OK)
+                outError(ERR_WRITE_OUTPUT, job.filename.c_str());
+        } else {
+            try {
+                ofstream out;
+                out.exceptions(ios::failbit | ios::badbit);
+                out.open(job.filename.c_str(), ios::out | ios::app);
+                out.write(job.data.c_str(), job.data.length());
+                out.close();
+            } catch (ios::failure &) {
+                outError(ERR_WRITE_OUTPUT, job.filename.c_str());
+            }
+        }
+        return getFileSize(job.filename) - old_size;
+    }
+
+    std::thread worker;
+    std::mutex mtx;
+    std::condition_variable cond;
+    deque<Job> jobs;
+    bool busy;
+    bool stop;
+};
+
 Checkpoint::Checkpoint() {
 	filename = "";
     prev_dump_time = 0;
@@ -22,14 +207,69 @@ Checkpoint::Checkpoint() {
     struct_name = "";
     compression = true;
     header = CKP_HEADER;
+    dirty_all = true;
+    num_records = 0;
+    record_size = 0;
+    full_size = 0;
+    num_full_dumps = 0;
+    num_record_dumps = 0;
+    dump_time = 0.0;
+    max_dump_time = 0.0;
+    writer = nullptr;
+}
+
+Checkpoint::Checkpoint(const Checkpoint &other) : map<string, string>(other) {
+    filename = other.filename;
+    prev_dump_time = other.prev_dump_time;
+    dump_interval = other.dump_interval;
+    dump_count = other.dump_count;
+    struct_name = other.struct_name;
+    list_element = other.list_element;
+    list_element_precision = other.list_element_precision;
+    compression = other.compression;
+    header = other.header;
+    dirty_all = true;
+    num_records = 0;
+    record_size = 0;
+    full_size = 0;
+    num_full_dumps = 0;
+    num_record_dumps = 0;
+    dump_time = 0.0;
+    max_dump_time = 0.0;
+    writer = nullptr;
+}
+
+Checkpoint &Checkpoint::operator=(const Checkpoint &other) {
+    if (this == &other)
+        return *this;
+    map<string, string>::operator=(other);
+    filename = other.filename;
+    prev_dump_time = other.prev_dump_time;
+    dump_interval = other.dump_interval;
+    dump_count = other.dump_count;
+    struct_name = other.struct_name;
+    list_element = other.list_element;
+    list_element_precision = other.list_element_precision;
+    compression = other.compression;
+    header = other.header;
+    dirty_keys.clear();
+    dirty_all = true;
+    return *this;
 }
 
-
 Checkpoint::~Checkpoint() {
+    if (writer) {
+        writer->wait();
+        if (verbose_mode >= VB_MED)
+            reportDumpStats(cout);
+        delete writer;
+    }
 }
 
 
 void Checkpoint::setFileName(string filename) {
+    if (filename != this->filename)
+        dirty_all = true;
 	this->filename = filename;
 }
 
@@ -39,8 +279,29 @@ void Checkpoint::load(istream &in) {
     string struct_name;
     size_t pos;
     int listid = 0;
+    // entries of an appended record, only applied once the record is complete
+    vector<pair<string, string> > record;
+    bool in_record = false;
     while (!in.eof()) {
         safeGetline(in, line);
+        if (line == CKP_RECORD_BEGIN) {
+            record.clear();
+            in_record = true;
+            struct_name = "";
+            continue;
+        }
+        if (in_record && line == CKP_RECORD_END) {
+            for (auto &entry : record) {
+                if (entry.first.empty())
+                    map<string, string>::erase(entry.second);
+                else
+                    (*this)[entry.first] = entry.second;
+            }
+            record.clear();
+            in_record = false;
+            struct_name = "";
+            continue;
+        }
         pos = line.find('#');
         if (pos != string::npos)
             line.erase(pos);
@@ -54,9 +315,15 @@ void Checkpoint::load(istream &in) {
         line.erase(0, line.find_first_not_of(" \n\r\t"));
         if (line.empty()) continue;
         pos = line.find(": ");
-        if (pos != string::npos) {
+        if (in_record && struct_name.empty() && line.compare(0, 2, "~ ") == 0) {
+            // erased key in a record
+            record.push_back(make_pair(string(), line.substr(2)));
+        } else if (pos != string::npos) {
             // mapping
-            (*this)[struct_name + line.substr(0, pos)] = line.substr(pos+2);
+            if (in_record)
+                record.push_back(make_pair(struct_name + line.substr(0, pos), line.substr(pos+2)));
+            else
+                (*this)[struct_name + line.substr(0, pos)] = line.substr(pos+2);
         } else if (line[line.length()-1] == ':') {
             // start a new struct
             line.erase(line.length()-1);
@@ -66,10 +333,15 @@ void Checkpoint::load(istream &in) {
             continue;
         } else {
             // collection
-            (*this)[struct_name + convertIntToString(listid)] = line;
+            if (in_record)
+                record.push_back(make_pair(struct_name + convertIntToString(listid), line));
+            else
+                (*this)[struct_name + convertIntToString(listid)] = line;
             listid++;
         }
     }
+    if (in_record)
+        outWarning("Incomplete record at the end of checkpoint file " + filename + " ignored");
 }
 
 
@@ -110,6 +382,8 @@ bool Checkpoint::load() {
 }
 
 void Checkpoint::setCompression(bool compression) {
+    if (compression != this->compression)
+        dirty_all = true;
     this->compression = compression;
 }
 
@@ -118,6 +392,7 @@ void Checkpoint::setCompression(bool compression) {
     @param header header line
 */
 void Checkpoint::setHeader(string header) {
+    dirty_all = true;
     this->header = "--- # " + header;
 }
 
@@ -143,6 +418,29 @@ void Checkpoint::dump(ostream &out) {
     }
 }
 
+void Checkpoint::dumpRecord(ostream &out) {
+    string struct_name;
+    size_t pos;
+    out << CKP_RECORD_BEGIN << endl;
+    for (auto key = dirty_keys.begin(); key != dirty_keys.end(); key++) {
+        iterator i = find(*key);
+        if (i == end()) {
+            out << "~ " << *key << endl;
+            struct_name = "";
+        } else if ((pos = i->first.find(CKP_SEP)) != string::npos) {
+            if (struct_name != i->first.substr(0, pos)) {
+                struct_name = i->first.substr(0, pos);
+                out << struct_name << ':' << endl;
+            }
+            out << ' ' << i->first.substr(pos+1) << ": " << i->second << endl;
+        } else {
+            out << i->first << ": " << i->second << endl;
+            struct_name = "";
+        }
+    }
+    out << CKP_RECORD_END << endl;
+}
+
 void Checkpoint::dump(bool force) {
     if (filename == "")
         return;
@@ -151,41 +449,46 @@ void Checkpoint::dump(bool force) {
         return;
     }
     prev_dump_time = getRealTime();
-    string filename_tmp = filename + ".tmp";
-    if (fileExists(filename_tmp)) {
-        outWarning("IQ-TREE was killed while writing temporary checkpoint file " + filename_tmp);
-        outWarning("You should increase checkpoint interval from the default 60 seconds");
-        outWarning("via -cptime option to avoid too frequent checkpoint for large datasets");
+    if (!writer) {
+        string filename_tmp = filename + ".tmp";
+        if (fileExists(filename_tmp)) {
+            outWarning("IQ-TREE was killed while writing temporary checkpoint file " + filename_tmp);
+            outWarning("You should increase checkpoint interval from the default 60 seconds");
+            outWarning("via -cptime option to avoid too frequent checkpoint for large datasets");
+        }
+        writer = new CheckpointWriter;
     }
-    try {
-        ostream *out;
-        if (compression) 
-            out = new ogzstream(filename_tmp.c_str());
-        else
-            out = new ofstream(filename_tmp.c_str());
-        out->exceptions(ios::failbit | ios::badbit);
-        *out << header << endl;
-        // call dump stream
-        dump(*out);
-        if (compression)
-            ((ogzstream*)out)->close();
-        else
-            ((ofstream*)out)->close();
-        delete out;
-//        cout << "Checkpoint dumped" << endl;
-        if (fileExists(filename)) {
-            if (std::remove(filename.c_str()) != 0)
-                outError("Cannot remove file ", filename);
+    // rewrite the whole file if the appended records outgrow the last full snapshot
+    bool full = dirty_all || num_records >= CKP_MAX_RECORDS || record_size > full_size;
+    if (full || !dirty_keys.empty()) {
+        ostringstream out;
+        if (full) {
+            out << header << endl;
+            dump(out);
+        } else {
+            dumpRecord(out);
         }
-        if (std::rename(filename_tmp.c_str(), filename.c_str()) != 0)
-            outError("Cannot rename file ", filename_tmp);
-    } catch (ios::failure &) {
-        outError(ERR_WRITE_OUTPUT, filename.c_str());
+        string data = out.str();
+        if (full) {
+            full_size = data.length();
+            record_size = 0;
+            num_records = 0;
+            num_full_dumps++;
+        } else {
+            record_size += data.length();
+            num_records++;
+            num_record_dumps++;
+        }
+        dirty_keys.clear();
+        dirty_all = false;
+        writer->submit(filename, compression, full, data);
     }
+    if (force)
+        writer->wait();
     if (Params::getInstance().print_all_checkpoints) {
         // Feature request by Nick Goldman
         dump_count++;
-        filename_tmp = (string)Params::getInstance().out_prefix + "." + convertIntToString(dump_count) + ".ckp.gz";
+        string filename_tmp = (string)Params::getInstance().out_prefix + "." + convertIntToString(dump_count) + ".ckp.gz";
         try {
             ostream *out;
             if (compression)
@@ -206,15 +509,59 @@ void Checkpoint::dump(bool force) {
         }
     } else {
         // check that the dumping time is too long and increase dump_interval if necessary
-        double dump_time = getRealTime() - prev_dump_time;
-        if (dump_time*20 > dump_interval) {
-            dump_interval = ceil(dump_time*20);
-            cout << "NOTE: " << dump_time << " seconds to dump checkpoint file, increase to "
+        double elapsed = getRealTime() - prev_dump_time;
+        dump_time += elapsed;
+        max_dump_time = max(max_dump_time, elapsed);
+        if (elapsed*20 > dump_interval) {
+            dump_interval = ceil(elapsed*20);
+            cout << "NOTE: " << elapsed << " seconds to dump checkpoint file, increase to "
             << dump_interval << endl;
         }
     }
 }
 
+void Checkpoint::reportDumpStats(ostream &out) {
+    int num_dumps = num_full_dumps + num_record_dumps;
+    if (!writer || num_dumps == 0)
+        return;
+    writer->wait();
+    out << "Checkpoint: " << num_full_dumps << " full and " << num_record_dumps << " incremental dumps, "
+        << writer->bytes_written << " bytes written" << endl;
+    out << "Checkpoint: " << dump_time * 1000.0 / num_dumps << " ms per dump (max "
+        << max_dump_time * 1000.0 << " ms) in the calling thread, ";
+    if (writer->num_writes > 0)
+        out << writer->write_time * 1000.0 / writer->num_writes << " ms per write (max "
+            << writer->max_write_time * 1000.0 << " ms) in the background" << endl;
+    else
+        out << "no write in the background" << endl;
+}
+
+void Checkpoint::setValue(const string &key, const string &value) {
+    iterator it = lower_bound(key);
+    if (it != end() && it->first == key) {
+        if (it->second == value)
+            return;
+        it->second = value;
+    } else {
+        insert(it, make_pair(key, value));
+    }
+    if (!dirty_all)
+        dirty_keys.insert(key);
+}
+
+void Checkpoint::clear() {
+    map<string, string>::clear();
+    dirty_keys.clear();
+    dirty_all = true;
+}
+
+Checkpoint::size_type Checkpoint::erase(const string &key) {
+    size_type count = map<string, string>::erase(key);
+    if (count && !dirty_all)
+        dirty_keys.insert(key);
+    return count;
+}
+
 bool Checkpoint::hasKey(string key) {
 	return (find(struct_name + key) != end());
 }
@@ -243,14 +590,20 @@ int Checkpoint::eraseKeyPrefix(string key_prefix) {
             break;
 
     }
-    if (count)
+    if (count) {
+        if (!dirty_all)
+            for (iterator it = first_it; it != i; it++)
+                dirty_keys.insert(it->first);
         erase(first_it, i);
+    }
     return count;
 }
 
 int Checkpoint::keepKeyPrefix(string key_prefix) {
     map<string,string> newckp;
     int count = 0;
+    dirty_keys.clear();
+    dirty_all = true;
     erase(begin(), lower_bound(key_prefix));
     
     for (iterator i = begin(); i != end(); i++) {
@@ -10,6 +10,7 @@
 
 #include <stdio.h>
 #include <map>
+#include <set>
 #include <string>
 #include <sstream>
 #include <cassert>
@@ -44,6 +45,8 @@
 
 const char CKP_SEP = '!';
 
+class CheckpointWriter;
+
 /** checkpoint stream */
 class CkpStream : public stringstream {
 public:
@@ -72,6 +75,12 @@ public:
     /** constructor */
 	Checkpoint();
 
+    /** copy constructor, the copy gets its own background writer */
+    Checkpoint(const Checkpoint &other);
+
+    /** assignment operator, the next dump will write all entries */
+    Checkpoint &operator=(const Checkpoint &other);
+
     /** destructor */
 	virtual ~Checkpoint();
 
@@ -113,11 +122,33 @@ public:
 	void dump(ostream &out);
 
 	/**
-	 * dump checkpoint information into file
+	 * dump checkpoint information into file.
+	 * Only entries changed since the previous dump are appended to the file as a record,
+	 * the file is rewritten in full every CKP_MAX_RECORDS records.
+	 * The file is written by a background thread, except for forced dumps, which wait until
+	 * the file is completely written
 	 * @param force TRUE to dump no matter if time interval exceeded or not
 	 */
 	void dump(bool force = false);
 
+    /**
+        print statistics of checkpoint dumping
+        @param out output stream
+    */
+    void reportDumpStats(ostream &out);
+
+    /** remove all entries, the next dump will write all entries */
+    void clear();
+
+    using map<string, string>::erase;
+
+    /**
+        erase an entry
+        @param key full key name
+        @return number of entries removed
+    */
+    size_type erase(const string &key);
+
     /**
         set dumping interval in seconds
         @param interval dumping interval
@@ -327,7 +358,7 @@ public:
         CkpStream ss;
         ss.precision(CKP_PRECISION);
         ss << value;
-        (*this)[key] = ss.str();
+        setValue(key, ss.str());
     }
     
     /** 
@@ -354,7 +385,7 @@ public:
             if (i > 0) ss << ", ";
             ss << value[i];
         }
-        (*this)[key] = ss.str();
+        setValue(key, ss.str());
     }
 
     /**
@@ -375,7 +406,7 @@ public:
             if (i > 0) ss << ", ";
             ss << value[i];
         }
-        (*this)[key] = ss.str();
+        setValue(key, ss.str());
     }
     
     /*-------------------------------------------------------------
@@ -464,6 +495,46 @@ protected:
     
 private:
 
+    /**
+        set the value of a full key and mark it for the next dump if changed
+        @param key full key name
+        @param value value
+    */
+    void setValue(const string &key, const string &value);
+
+    /**
+        dump the entries in dirty_keys as a record, erased keys are written as '~ key'
+        @param out output stream
+    */
+    void dumpRecord(ostream &out);
+
+    /** keys changed or erased since the previous dump */
+    set<string> dirty_keys;
+
+    /** true if the next dump must rewrite all entries */
+    bool dirty_all;
+
+    /** number of records appended since the previous full dump */
+    int num_records;
+
+    /** number of bytes of records appended since the previous full dump */
+    size_t record_size;
+
+    /** number of bytes of the previous full dump */
+    size_t full_size;
+
+    /** number of full dumps */
+    int num_full_dumps;
+
+    /** number of record dumps */
+    int num_record_dumps;
+
+    /** total and maximum time in seconds that dump() blocked the caller */
+    double dump_time, max_dump_time;
+
+    /** background thread writing checkpoint file */
+    CheckpointWriter *writer;
+
     /** name of the current nested key */
     string struct_name;
 
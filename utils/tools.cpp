@@ -53,6 +53,7 @@
 #include "alignment/alignment.h"
 
 VerboseMode verbose_mode;
+thread_local string *thread_out_buffer = nullptr;
 extern void printCopyright(ostream &out);
 
 #if defined(WIN32)
@@ -1952,6 +1953,10 @@ void parseArg(int argc, char *argv[], Params &params) {
                 params.phylip_sequential_format = true;
                 continue;
             }
+            if (strcmp(argv[cnt], "--aln-cache") == 0) {
+                params.aln_cache = true;
+                continue;
+            }
             if (strcmp(argv[cnt], "--symtest") == 0) {
                 params.symtest = SYMTEST_MAXDIV;
                 continue;
@@ -3065,6 +3070,10 @@ void parseArg(int argc, char *argv[], Params &params) {
 				params.store_trans_matrix = true;
 				continue;
 			}
+			if (strcmp(argv[cnt], "-nomstore") == 0) {
+				params.store_trans_matrix = false;
+				continue;
+			}
 			if (strcmp(argv[cnt], "-nni_lh") == 0) {
 				params.nni_lh = true;
 				continue;
@@ -3363,6 +3372,10 @@ void parseArg(int argc, char *argv[], Params &params) {
                 params.HMM_no_avg_brlen = true;
                 continue;
             }
+            if (strcmp(argv[cnt], "-hmm_linear") == 0) {
+                params.HMM_linear_space = true;
+                continue;
+            }
             if (strcmp(argv[cnt], "-tmix_opt_method") == 0) {
                 cnt++;
                 if (cnt >= argc)
@@ -3995,6 +4008,10 @@ void parseArg(int argc, char *argv[], Params &params) {
 					throw "Epsilon must be positive";
 				continue;
 			}
+			if (strcmp(argv[cnt], "--bcompact") == 0) {
+				params.ufboot_compact = true;
+				continue;
+			}
 			if (strcmp(argv[cnt], "-wbt") == 0 || strcmp(argv[cnt], "--wbt") == 0 || strcmp(argv[cnt], "--boot-trees") == 0) {
 				params.print_ufboot_trees = 1;
 				continue;
@@ -4118,6 +4135,24 @@ void parseArg(int argc, char *argv[], Params &params) {
                 }
 				continue;
 			}
+            if (strcmp(argv[cnt], "--boot-threads") == 0) {
+                cnt++;
+                if (cnt >= argc)
+                    throw "Use --boot-threads NUM";
+                params.num_threads_per_boot = convert_int(argv[cnt]);
+                if (params.num_threads_per_boot < 0)
+                    throw "--boot-threads must be non-negative";
+                continue;
+            }
+            if (strcmp(argv[cnt], "--lh-cache") == 0) {
+                cnt++;
+                if (cnt >= argc)
+                    throw "Use --lh-cache NUM";
+                params.lh_cache_size = convert_double(argv[cnt]);
+                if (params.lh_cache_size < 0)
+                    throw "--lh-cache must be non-negative";
+                continue;
+            }
             if (strcmp(argv[cnt], "--save-mem-buffer") == 0) {
                 params.buffer_mem_save = true;
                 continue;
@@ -4618,6 +4653,21 @@ void parseArg(int argc, char *argv[], Params &params) {
                 continue;
             }
 
+            if (strcmp(argv[cnt], "--nni-thread") == 0) {
+                cnt++;
+                if (cnt >= argc)
+                    throw "Use --nni-thread AUTO|SITE|BRANCH";
+                if (iEquals(argv[cnt], "AUTO"))
+                    params.nni_thread_mode = NNI_THREAD_AUTO;
+                else if (iEquals(argv[cnt], "SITE"))
+                    params.nni_thread_mode = NNI_THREAD_SITE;
+                else if (iEquals(argv[cnt], "BRANCH"))
+                    params.nni_thread_mode = NNI_THREAD_BRANCH;
+                else
+                    throw "Use --nni-thread AUTO|SITE|BRANCH";
+                continue;
+            }
+
             if (strcmp(argv[cnt], "--weighted-perturbation") == 0 || strcmp(argv[cnt], "-weighted-perturbation") == 0) {
                 params.weightedPerturbation = true;
                 continue;
@@ -5814,6 +5864,7 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  --seed NUM           Random seed number, normally used for debugging purpose" << endl
     << "  --safe               Safe likelihood kernel to avoid numerical underflow" << endl
     << "  --mem NUM[G|M|%]     Maximal RAM usage in GB | MB | %" << endl
+    << "  --lh-cache NUM       Subtree likelihood cache size relative to tree (default: 0.5)" << endl
     << "  --runs NUM           Number of indepedent runs (default: 1)" << endl
     << "  -v, --verbose        Verbose mode, printing more messages to screen" << endl
     << "  -V, --version        Display version number" << endl
@@ -5823,12 +5874,14 @@ void usage_iqtree(char* argv[], bool full_command) {
 #ifdef _OPENMP
     << "  -T NUM|AUTO          No. cores/threads or AUTO-detect (default: 1)" << endl
     << "  --threads-max NUM    Max number of threads for -T AUTO (default: all cores)" << endl
+    << "  --nni-thread STRING  AUTO|SITE|BRANCH parallel NNI evaluation (default: AUTO)" << endl
 #endif
     << endl << "CHECKPOINT:" << endl
     << "  --redo               Redo both ModelFinder and tree search" << endl
     << "  --redo-tree          Restore ModelFinder and only redo tree search" << endl
     << "  --undo               Revoke finished run, used when changing some options" << endl
     << "  --cptime NUM         Minimum checkpoint interval (default: 60 sec and adapt)" << endl
+    << "  --aln-cache          Cache site patterns in PREFIX.alncache for fast restart" << endl
     << endl << "PARTITION MODEL:" << endl
     << "  -p FILE|DIR          NEXUS/RAxML partition file or directory with alignments" << endl
     << "                       Edge-linked proportional partition model" << endl
@@ -5874,6 +5927,7 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  --nstep NUM          Iterations for UFBoot stopping rule (default: 100)" << endl
     << "  --bcor NUM           Minimum correlation coefficient (default: 0.99)" << endl
     << "  --beps NUM           RELL epsilon to break tie (default: 0.5)" << endl
+    << "  --bcompact           Store UFBoot samples as 8-bit counts (default: AUTO)" << endl
     << "  --bnni               Optimize UFBoot trees by NNI on bootstrap alignment" << endl
     << endl << "NON-PARAMETRIC BOOTSTRAP/JACKKNIFE:" << endl
     << "  -b, --boot NUM       Replicates for bootstrap + ML tree + consensus tree" << endl
@@ -5881,6 +5935,9 @@ void usage_iqtree(char* argv[], bool full_command) {
     << "  --jack-prop NUM      Subsampling proportion for jackknife (default: 0.5)" << endl
     << "  --bcon NUM           Replicates for bootstrap + consensus tree" << endl
     << "  --bonly NUM          Replicates for bootstrap only" << endl
+#ifdef _OPENMP
+    << "  --boot-threads NUM   Threads per concurrent replicate (default: AUTO)" << endl
+#endif
 #ifdef USE_BOOSTER
     << "  --tbe                Transfer bootstrap expectation" << endl
 #endif
@@ -6430,6 +6487,7 @@ int finish_random() {
 /******************/
 
 int *randstream;
+thread_local int *thread_randstream = nullptr;
 /**
    vector of random streams for multiple threads
  **/
@@ -6564,6 +6622,8 @@ double random_double(int *rstream) {
 #elif RAN_TYPE == RAN_SPRNG
     if (rstream)
         return sprng(rstream);
+    else if (thread_randstream)
+        return sprng(thread_randstream);
     else
         return sprng(randstream);
 #else /* NO_SPRNG */
@@ -6573,6 +6633,8 @@ double random_double(int *rstream) {
 #if RAN_TYPE == RAN_SPRNG
     if (rstream)
         return sprng(rstream);
+    else if (thread_randstream)
+        return sprng(thread_randstream);
     else
         return sprng(randstream);
 #else /* NO_SPRNG */
@@ -7133,6 +7195,7 @@ void Params::setDefault() {
 
     aln_file = nullptr;
     phylip_sequential_format = false;
+    aln_cache = false;
     symtest = SYMTEST_NONE;
     symtest_only = false;
     symtest_remove = 0;
@@ -7212,7 +7275,7 @@ void Params::setDefault() {
     optimize_mixmodel_weight = false;
     optimize_mixmodel_freq = false;
     optimize_rate_matrix = false;
-    store_trans_matrix = false;
+    store_trans_matrix = true;
     parallel_over_sites = false;
     parallel_per_partition = false;
     parallel_round_robin = false;
@@ -7259,6 +7322,7 @@ void Params::setDefault() {
     optimize_params_use_hmm_tm = false;
     HMM_no_avg_brlen = false;
     HMM_min_stran = 0.0;
+    HMM_linear_space = false;
     treemix_optimize_methods = "mast"; // default is MAST
 
     fixed_branch_length = BRLEN_OPTIMIZE;
@@ -7334,6 +7398,7 @@ void Params::setDefault() {
 
     gbo_replicates = 0;
     ufboot_epsilon = 0.5;
+    ufboot_compact = false;
     check_gbo_sample_size = 0;
     use_rell_method = true;
     use_elw_method = false;
@@ -7402,6 +7467,7 @@ void Params::setDefault() {
     num_threads_max = 10000;
     num_threads_orig = 0;
     openmp_by_model = false;
+    nni_thread_mode = NNI_THREAD_AUTO;
     model_test_criterion = MTC_BIC;
     //    model_test_stop_rule = MTC_ALL;
     model_test_sample_size = 0;
@@ -7419,6 +7485,8 @@ void Params::setDefault() {
     print_branch_lengths = false;
     lh_mem_save = LM_PER_NODE; // auto detect
     buffer_mem_save = false;
+    lh_cache_size = 0.5;
+    num_threads_per_boot = 0;
     start_tree = STT_PLL_PARSIMONY;
     start_tree_subtype_name = StartTree::Factory::getNameOfDefaultTreeBuilder();
 
@@ -7545,6 +7613,7 @@ void Params::setDefault() {
     alisim_deletion_distribution = IndelDistribution(ZIPF,1.7,100);
     alisim_mean_deletion_size = -1;
     alisim_simulation_thresh = 0.001;
+    alisim_gillespie_threads = 1;
     delay_msgs = "";
     alisim_no_export_sequence_wo_gaps = false;
     alisim_mixture_at_sub_level = false;
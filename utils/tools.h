@@ -450,6 +450,12 @@ enum VerboseMode {
  */
 extern VerboseMode verbose_mode;
 
+/**
+        if set, screen and log output of the current thread is collected here,
+        used when independent analyses run concurrently
+ */
+extern thread_local string *thread_out_buffer;
+
 /**
         consensus reconstruction type
  */
@@ -557,6 +563,14 @@ enum LhMemSave {
 	LM_PER_NODE, LM_MEM_SAVE
 };
 
+/**
+ *  Parallelisation of NNI evaluation: automatic choice, over patterns
+ *  inside the likelihood kernel, or over branches with one tree copy per thread
+ */
+enum NNIThreadMode {
+    NNI_THREAD_AUTO, NNI_THREAD_SITE, NNI_THREAD_BRANCH
+};
+
 enum SiteLoglType {
     WSL_NONE, WSL_SITE, WSL_RATECAT, WSL_MIXTURE, WSL_MIXTURE_RATECAT, WSL_TMIXTURE
 };
@@ -949,6 +963,9 @@ public:
     /** true if sequential phylip format is used, default: false (interleaved format) */
     bool phylip_sequential_format;
 
+    /** true to cache the site patterns of alignment files in a binary file for fast restart */
+    bool aln_cache;
+
     /**
      SYMTEST_NONE to not perform test of symmetry of Jermiin et al. (default)
      SYMTEST_MAXDIV to perform symmetry test on the pair with maximum divergence
@@ -1690,7 +1707,7 @@ public:
     bool optimize_rate_matrix;
 
     /**
-            TRUE to store transition matrix into a hash table for computation efficiency
+            TRUE (default) to store transition matrix into a hash table for computation efficiency
      */
     bool store_trans_matrix;
 
@@ -1885,6 +1902,9 @@ public:
     /** minimum value allowed for HMM transition probability between the same tree (category) */
     double HMM_min_stran;
 
+    /** TRUE to run the HMM forward/backward recursions with scaled likelihoods instead of log-likelihoods */
+    bool HMM_linear_space;
+
     /** optimization methods: hmm / hmm2mast / mast2hmm / mast */
     string treemix_optimize_methods;
 
@@ -2249,6 +2269,12 @@ public:
 	 */
 	double ufboot_epsilon;
 
+    /**
+            TRUE to store UFBoot samples as 8-bit pattern counts instead of floating-point weights,
+            switched on automatically if the weights take too much memory
+     */
+    bool ufboot_compact;
+
     /**
             TRUE to check with different max_candidate_trees
      */
@@ -2385,6 +2411,9 @@ public:
     /** true to parallel ModelFinder by models instead of sites */
     bool openmp_by_model;
 
+    /** parallelise NNI evaluation over sites or branches (default: NNI_THREAD_AUTO) */
+    NNIThreadMode nni_thread_mode;
+
     /** either MTC_AIC, MTC_AICc, MTC_BIC */
     ModelTestCriterion model_test_criterion;
 
@@ -2446,6 +2475,12 @@ public:
     /** maximum size of memory allowed to use */
     double max_mem_size;
 
+    /** number of threads per replicate when running standard bootstrap replicates concurrently, 0 for AUTO */
+    int num_threads_per_boot;
+
+    /** size of the subtree likelihood cache as proportion of partial likelihood vectors, 0 to disable */
+    double lh_cache_size;
+
 	/* TRUE to print .splits file in star-dot format */
 	bool print_splits_file;
     
@@ -2746,6 +2781,12 @@ public:
     */
     double alisim_simulation_thresh;
     
+    /**
+    *  number of threads to simulate the Gillespie events of a branch on segments of the sequence in parallel,
+    *  set from -T in simulations with Indels, which otherwise run in a single thread
+    */
+    int alisim_gillespie_threads;
+    
     /**
     *  messages which are delayed to show
     */
@@ -3496,6 +3537,8 @@ double computePValueChiSquare(double x, int df);
 /*--------------------------------------------------------------*/
 
 extern int *randstream;
+/** random stream of the current thread, used instead of randstream if set */
+extern thread_local int *thread_randstream;
 extern vector<int*> rstream_vec;
 extern vector<default_random_engine> generator_vec;
 